@@ -39,6 +39,7 @@ namespace ClassGame {
                     ImGui::Text("Game Over!");
                     ImGui::Text("Winner: %d", gameWinner);
                     if (ImGui::Button("Reset Game")) {
+                        game->stopSearch();
                         game->stopGame();
                         game->setUpBoard();
                         gameOver = false;
@@ -76,14 +77,23 @@ namespace ClassGame {
                         ImGui::Text("%s", stateString.substr(y*stride,stride).c_str());
                     }
                     ImGui::Text("Current Board State: %s", game->stateString().c_str());
+                    std::string searchInfo = game->searchInfoString();
+                    if (!searchInfo.empty()) {
+                        ImGui::TextWrapped("%s", searchInfo.c_str());
+                    }
                 }
                 ImGui::End();
 
                 ImGui::Begin("GameWindow");
                 if (game) {
-                    if (game->gameHasAI() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
+                    // the AI searches on its own thread, the frame only plays its move once it's ready
+                    if (game->gameHasAI())
                     {
-                        game->updateAI();
+                        game->poll();
+                        if (!gameOver && !game->isSearching() && (game->getCurrentPlayer()->isAIPlayer() || game->_gameOptions.AIvsAI))
+                        {
+                            game->startSearch();
+                        }
                     }
                     game->drawFrame();
                 }
@@ -2,6 +2,8 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
+#include <cstdint>
+#include <functional>
 #include <iostream>
 
 enum ChessPiece
@@ -51,6 +53,11 @@ public:
         _data &= other;
         return *this;
     }
+    BitBoard &operator^=(const uint64_t other)
+    {
+        _data ^= other;
+        return *this;
+    }
     BitBoard operator^(const uint64_t other) 
     {
         _data ^= other;
@@ -94,18 +101,68 @@ private:
 #endif
     };
 };
-struct BitMove
+// what kind of move a BitMove is, its top 4 bits. bit 2 marks captures and
+// bit 3 promotions, whose low 2 bits then give the piece (knight..queen)
+enum MoveFlag
 {
-    uint8_t from;
-    uint8_t to;
-    uint8_t piece;
-    BitMove(int from, int to, ChessPiece piece)
-        : from(from), to(to), piece(piece) {}
-    BitMove() : from(0), to(0), piece(NoPiece) {}
-    bool operator==(const BitMove &other) const
-    {
-        return from == other.from &&
-               to == other.to &&
-               piece == other.piece;
-    }
-};
\ No newline at end of file
+    QUIET_MOVE = 0,
+    DOUBLE_PAWN_PUSH = 1,
+    KING_CASTLE = 2,
+    QUEEN_CASTLE = 3,
+    CAPTURE = 4,
+    EN_PASSANT = 5,
+    PROMOTION = 8,
+    KNIGHT_PROMOTION = 8,
+    BISHOP_PROMOTION = 9,
+    ROOK_PROMOTION = 10,
+    QUEEN_PROMOTION = 11,
+    KNIGHT_PROMOTION_CAPTURE = 12,
+    BISHOP_PROMOTION_CAPTURE = 13,
+    ROOK_PROMOTION_CAPTURE = 14,
+    QUEEN_PROMOTION_CAPTURE = 15
+};
+
+//
+// a move packed into 16 bits: from square (bits 0-5), to square (6-11) and a
+// MoveFlag (12-15). a1a1 never happens, so all zero doubles as "no move".
+//
+class BitMove
+{
+public:
+    constexpr BitMove() : _data(0) {}
+    constexpr BitMove(int from, int to, int flags = QUIET_MOVE)
+        : _data((uint16_t)(from | (to << 6) | (flags << 12))) {}
+
+    static constexpr BitMove none() { return BitMove(); }
+    static constexpr BitMove fromRaw(uint16_t raw) { BitMove move; move._data = raw; return move; }
+
+    constexpr int from() const { return _data & 63; }
+    constexpr int to() const { return (_data >> 6) & 63; }
+    constexpr int flags() const { return _data >> 12; }
+    constexpr uint16_t raw() const { return _data; }
+
+    constexpr bool isNone() const { return _data == 0; }
+    constexpr bool isCapture() const { return (flags() & CAPTURE) != 0; }
+    constexpr bool isPromotion() const { return (flags() & PROMOTION) != 0; }
+    constexpr bool isQuiet() const { return !isCapture() && !isPromotion(); }
+    constexpr bool isEnPassant() const { return flags() == EN_PASSANT; }
+    constexpr bool isCastle() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+    constexpr ChessPiece promotionPiece() const { return isPromotion() ? (ChessPiece)(Knight + (flags() & 3)) : NoPiece; }
+
+    constexpr bool operator==(const BitMove &other) const { return _data == other._data; }
+    constexpr bool operator!=(const BitMove &other) const { return _data != other._data; }
+
+private:
+    uint16_t _data;
+};
+
+static_assert(sizeof(BitMove) == 2, "BitMove should stay 16 bits");
+
+namespace std
+{
+template <>
+struct hash<BitMove>
+{
+    size_t operator()(const BitMove &move) const noexcept { return hash<uint16_t>()(move.raw()); }
+};
+}
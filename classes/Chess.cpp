@@ -1,39 +1,31 @@
 #include "Chess.h"
 #include "MagicBitboards.h"
+#include <algorithm>
 #include <limits>
 #include <cmath>
 #include "BitHolder.h"
-#include "PieceSquare.h"
 
 Chess::Chess()
 {
     _grid = new Grid(8, 8);
-    // Precompute knight move bitboards for each square
-    
+    // slider tables are process wide, only the first game pays for them
     initMagicBitboards();
-
-    for(int i = 0; i < 128; i++) { _bitBoardLookup[i] = 0; }
-    // Map characters from pieceNotation / FEN to our bitboard indices
-    _bitBoardLookup['0'] = EMPTY_SQUARES;
-    _bitBoardLookup['P'] = WHITE_PAWNS;
-    _bitBoardLookup['N'] = WHITE_KNIGHTS;
-    _bitBoardLookup['B'] = WHITE_BISHOPS;
-    _bitBoardLookup['R'] = WHITE_ROOKS;
-    _bitBoardLookup['Q'] = WHITE_QUEENS;
-    _bitBoardLookup['K'] = WHITE_KING;
-    _bitBoardLookup['p'] = BLACK_PAWNS;
-    _bitBoardLookup['n'] = BLACK_KNIGHTS;
-    _bitBoardLookup['b'] = BLACK_BISHOPS;
-    _bitBoardLookup['r'] = BLACK_ROOKS;
-    _bitBoardLookup['q'] = BLACK_QUEENS;
-    _bitBoardLookup['k'] = BLACK_KING;
-
-    
+    // a network next to the other resources replaces the classical evaluation,
+    // without one (or with one that doesn't load) nothing changes
+    if (!networkLoaded()) {
+        loadNetwork("resources/nn.nnue");
+    }
+    _searchDone = false;
+    _pondering = false;
+    // runs on the search thread, poll() picks the reports up on the UI thread
+    _search.setInfoHandler([this](const SearchInfo& info) {
+        _searchProgress.push(info);
+    });
 }
 
 Chess::~Chess()
 {
-    cleanupMagicBitboards();
+    stopSearch();
     delete _grid;
 }
 
@@ -73,7 +65,18 @@ void Chess::setUpBoard()
     _grid->initializeChessSquares(pieceSize, "boardsquare.png");
     FENtoBoard("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
     _currentPlayer = WHITE;
-    _moves = generateAllMoves(stateString(), _currentPlayer);
+    // 5 minutes + 2 seconds a move for the AI, searching at least 2 and at most 32 plies
+    _gameOptions.AIDepthSearches = 2;
+    _gameOptions.AIMAXDepth = 32;
+    _gameOptions.AIClockMs = 5 * 60 * 1000;
+    _gameOptions.AIIncrementMs = 2000;
+    _gameOptions.AIMovesToGo = 0;
+    _gameOptions.AIPonder = true;
+    _gameOptions.AIThreads = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+    _search.resizeHash(_gameOptions.AIHashSizeMB);
+    _search.newGame();
+    _position.setFromFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+    generateAllMoves(_position, _moves);
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
@@ -162,9 +165,9 @@ bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src)
     if (sourceSquare) {
         int squareIndex = sourceSquare->getSquareIndex();
         for (auto &move : _moves) {
-            if (move.from == squareIndex) {
+            if (move.from() == squareIndex) {
                 ret = true;
-                auto dest = _grid->getSquareByIndex(move.to);
+                auto dest = _grid->getSquareByIndex(move.to());
                 if (dest) dest->setHighlighted(true);
             }
         }
@@ -178,24 +181,78 @@ bool Chess::canBitMoveFrom(Bit &bit, BitHolder &src)
 bool Chess::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
     
+    ChessSquare* srcSquare = (ChessSquare *)&src;
     ChessSquare* destSquare = (ChessSquare *)&dst;
-    if(destSquare) {
-        int squareIndex = destSquare->getSquareIndex();
-        for(auto move : _moves) {
-            if(move.to == squareIndex) {
-                return true;
-            }
-        }
+    if(srcSquare && destSquare) {
+        return !legalMove(srcSquare->getSquareIndex(), destSquare->getSquareIndex()).isNone();
     }
     return false;
 }
 
 void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 {
+    int from = ((ChessSquare *)&src)->getSquareIndex();
+    int to = ((ChessSquare *)&dst)->getSquareIndex();
+    playMove(legalMove(from, to));
+}
+
+// the legal move from -> to, a queen promotion when it's one of the four (the
+// board only knows where a piece was dropped), none if there isn't one
+BitMove Chess::legalMove(int from, int to) const
+{
+    BitMove found = BitMove::none();
+    for (auto &move : _moves) {
+        if (move.from() == from && move.to() == to) {
+            if (!move.isPromotion() || move.promotionPiece() == Queen) {
+                return move;
+            }
+            found = move;
+        }
+    }
+    return found;
+}
+
+// the moving piece is already on its target square, this does the rest on the
+// board (en passant victim, castling rook, promoted piece) and plays move
+void Chess::playMove(const BitMove& move)
+{
+    // the reply the AI was pondering on either came (keep searching, now on the AI's
+    // clock) or it didn't (that search is useless, a fresh one starts next frame)
+    if (_pondering) {
+        if (move == _ponderMove) {
+            _pondering = false;
+            _search.ponderHit();
+        } else {
+            stopSearch();
+        }
+    }
+
+    int side = _position.sideToMove();
+    if (move.isEnPassant()) {
+        _grid->getSquareByIndex(move.to() - 8 * side)->destroyBit();
+    }
+    if (move.isCastle()) {
+        int rookFrom = move.flags() == KING_CASTLE ? move.to() + 1 : move.to() - 2;
+        int rookTo = move.flags() == KING_CASTLE ? move.to() - 1 : move.to() + 1;
+        ChessSquare* rookSrc = _grid->getSquareByIndex(rookFrom);
+        Bit* rook = rookSrc->bit();
+        _grid->getSquareByIndex(rookTo)->dropBitAtPoint(rook, ImVec2(0, 0));
+        rookSrc->setBit(nullptr);
+    }
+    if (move.isPromotion()) {
+        ChessSquare* square = _grid->getSquareByIndex(move.to());
+        ChessPiece piece = move.promotionPiece();
+        Bit* promoted = PieceForPlayer(side == WHITE ? 0 : 1, piece);
+        promoted->setPosition(square->getPosition());
+        promoted->setGameTag(side == WHITE ? piece : piece + 128);
+        square->setBit(promoted);
+    }
+
     // After a successful move, switch players and generate new move list
     clearBoardHighlights();
-    _currentPlayer = (_currentPlayer == WHITE) ? BLACK : WHITE;
-    _moves = generateAllMoves(stateString(), _currentPlayer);
+    _position.commitMove(move);
+    _currentPlayer = _position.sideToMove();
+    generateAllMoves(_position, _moves);
     endTurn();
 }
 
@@ -204,6 +261,7 @@ void Chess::bitMovedFromTo(Bit &bit, BitHolder &src, BitHolder &dst)
 
 void Chess::stopGame()
 {
+    stopSearch();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
@@ -222,14 +280,18 @@ Player* Chess::ownerAt(int x, int y) const
     return square->bit()->getOwner();
 }
 
+// with no legal moves left the side to move is either mated or stalemated
 Player* Chess::checkForWinner()
 {
+    if (_moves.empty() && _position.inCheck()) {
+        return getPlayerAt(_position.sideToMove() == WHITE ? 1 : 0);
+    }
     return nullptr;
 }
 
 bool Chess::checkForDraw()
 {
-    return false;
+    return _moves.empty() && !_position.inCheck();
 }
 
 std::string Chess::initialStateString()
@@ -259,53 +321,6 @@ void Chess::setStateString(const std::string &s)
         }
     });
 }
-void Chess::addPawnBitboardMovesToList(std::vector<BitMove>& moves, const BitBoard bitboard, const int direction)
-{
-    if(bitboard.getData() == 0) return;
-    bitboard.forEachBit([&](int fromSquare) {
-        int toSquare = toSquare - 2;
-        moves.emplace_back(BitMove(fromSquare, toSquare, Pawn));
-    });
-}
-void Chess::generatePawnMoveList(std::vector<BitMove>& moves, const BitBoard pawns, const BitBoard emptySquares, const BitBoard enemyPieces, char color)
-{
-   if (pawns.getData() == 0) return;
-
-    uint64_t pawnsData = pawns.getData();
-    uint64_t emptyData = emptySquares.getData();
-    uint64_t enemyData = enemyPieces.getData();
-    // Single forward moves
-    uint64_t singleMovesData = (color == WHITE) ? ((pawnsData << 8) & emptyData) : ((pawnsData >> 8) & emptyData);
-    BitBoard singleMoves(singleMovesData);
-    singleMoves.forEachBit([&](int toSquare) {
-        int fromSquare = (color == WHITE) ? (toSquare - 8) : (toSquare + 8);
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
-    // Double forward moves from starting rank
-    uint64_t doubleMovesData = (color == WHITE) ? (((singleMovesData & Rank3) << 8) & emptyData) : (((singleMovesData & Rank6) >> 8) & emptyData);
-    BitBoard doubleMoves(doubleMovesData);
-    doubleMoves.forEachBit([&](int toSquare) {
-        int fromSquare = (color == WHITE) ? (toSquare - 16) : (toSquare + 16);
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
-
-    // Captures
-    uint64_t capturesLeftData = (color == WHITE) ? (((pawnsData & NotAFile) << 7) & enemyData) : (((pawnsData & NotAFile) >> 9) & enemyData);
-    uint64_t capturesRightData = (color == WHITE) ? (((pawnsData & NotHFile) << 9) & enemyData) : (((pawnsData & NotHFile) >> 7) & enemyData);
-    BitBoard capturesLeft(capturesLeftData);
-    BitBoard capturesRight(capturesRightData);
-
-    capturesLeft.forEachBit([&](int toSquare) {
-        int fromSquare = (color == WHITE) ? (toSquare - 7) : (toSquare + 9);
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
-    capturesRight.forEachBit([&](int toSquare) {
-        int fromSquare = (color == WHITE) ? (toSquare - 9) : (toSquare + 7);
-        moves.emplace_back(fromSquare, toSquare, Pawn);
-    });
-
-    
-}
 
 BitBoard Chess::generateKnightMoveBitboard(int square) {
     BitBoard bitboard = 0ULL;
@@ -327,220 +342,132 @@ BitBoard Chess::generateKnightMoveBitboard(int square) {
     return bitboard;
 }
 
-
-
-// Generate actual move objects from a bitboard
-void Chess::generateKnightMoves(std::vector<BitMove>& moves, BitBoard knightBoard, uint64_t occupancy) {
-    knightBoard.forEachBit([&](int fromSquare) {
-        BitBoard moveBitboard = BitBoard(KnightAttacks[fromSquare] & occupancy);
-        // Efficiently iterate through only the set bits
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Knight);
-        });
-    });
+SearchLimits Chess::searchLimits() const
+{
+    SearchLimits limits;
+    limits.timeLeftMs = _gameOptions.AIClockMs;
+    limits.incrementMs = _gameOptions.AIIncrementMs;
+    limits.movesToGo = _gameOptions.AIMovesToGo;
+    limits.minDepth = std::max(_gameOptions.AIDepthSearches, 1);
+    limits.maxDepth = _gameOptions.AIMAXDepth;
+    return limits;
 }
 
-void Chess::generateKingMoves(std::vector<BitMove>& moves, BitBoard kingBoard, uint64_t occupancy) {
-    kingBoard.forEachBit([&](int fromSquare) {
-        BitBoard moveBitboard = BitBoard(KingAttacks[fromSquare] & occupancy);
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, King);
-        });
-    });
+void Chess::updateAI() {
+    stopSearch();
+    _search.setThreads(_gameOptions.AIThreads);
+    SearchResult result = _search.think(_position, searchLimits());
+    poll();
+    playSearchResult(result);
 }
 
-
-void Chess::generateBishopMoves(std::vector<BitMove>& moves, BitBoard bishopBoard, uint64_t occupancy, uint64_t friendlies) {
-    bishopBoard.forEachBit([&](int fromSquare) {
-        BitBoard moveBitboard = BitBoard(getBishopAttacks(fromSquare, occupancy) & ~friendlies);
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Bishop);
-        });
-    });
+void Chess::startSearch()
+{
+    if (isSearching()) {
+        return;
+    }
+    launchSearch(_position);
 }
 
-void Chess::generateRookMoves(std::vector<BitMove>& moves, BitBoard rookBoard, uint64_t occupancy, uint64_t friendlies) {
-    rookBoard.forEachBit([&](int fromSquare) {
-        BitBoard moveBitboard = BitBoard(getRookAttacks(fromSquare, occupancy) & ~friendlies);
-        
-
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Rook);
-        });
+void Chess::launchSearch(const Position& position)
+{
+    _search.setThreads(_gameOptions.AIThreads);
+    _lastSearchInfo = SearchInfo();
+    _searchDone = false;
+    _searchThread = std::thread([this, position, limits = searchLimits()]() {
+        _searchResult = _search.think(position, limits);
+        _searchDone.store(true, std::memory_order_release);
     });
 }
 
-void Chess::generateQueenMoves(std::vector<BitMove>& moves, BitBoard queenBoard, uint64_t occupancy, uint64_t friendlies) {
-    queenBoard.forEachBit([&](int fromSquare) {
-        BitBoard moveBitboard = BitBoard(getQueenAttacks(fromSquare, occupancy) & ~friendlies);
-
-        moveBitboard.forEachBit([&](int toSquare) {
-           moves.emplace_back(fromSquare, toSquare, Queen);
-        });
-    });
+void Chess::startPondering(const BitMove& expectedReply)
+{
+    if (isSearching() || !_moves.contains(expectedReply)) {
+        return;
+    }
+    Position ponderPosition = _position;
+    ponderPosition.makeMove(expectedReply);
+    _ponderMove = expectedReply;
+    _pondering = true;
+    _search.setPondering(true);
+    launchSearch(ponderPosition);
 }
 
-
-
-
-std::vector<BitMove> Chess::generateAllMoves(const std::string& state, int playerColor)
+bool Chess::poll()
 {
-   std::vector<BitMove> moves;
-    moves.reserve(32);
-   
-   for (int i = 0; i < eNUM_BITBOARDS; i++) {
-        _bitboards[i] = 0;
+    SearchInfo info;
+    while (_searchProgress.pop(info)) {
+        _lastSearchInfo = info;
+    }
+    // a ponder search has nothing to play until the opponent's move is in
+    if (_pondering || !isSearching() || !_searchDone.load(std::memory_order_acquire)) {
+        return false;
     }
+    _searchThread.join();
+    playSearchResult(_searchResult);
+    return true;
+}
 
-    for( int i = 0; i < 64; i++ ) {
-        int bitIndex = _bitBoardLookup[state[i]];
-        _bitboards[bitIndex] |= 1ULL << i;
-        if (state[i] != '0') {
-            _bitboards[OCCUPANCY] |= 1ULL << i;
-            _bitboards[isupper(state[i]) ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES] |= 1ULL << i;
-        }
+void Chess::stopSearch()
+{
+    if (!isSearching()) {
+        return;
     }
-    _bitboards[WHITE_ALL_PIECEES] = _bitboards[WHITE_PAWNS].getData() | _bitboards[WHITE_KNIGHTS].getData() | _bitboards[WHITE_BISHOPS].getData() |
-                                    _bitboards[WHITE_ROOKS].getData() | _bitboards[WHITE_QUEENS].getData() | _bitboards[WHITE_KING].getData();
+    // keep asking until the thread is out of think(), a stop sent before think()
+    // started would be cleared by it
+    while (!_searchDone.load(std::memory_order_acquire)) {
+        _search.stop();
+        std::this_thread::yield();
+    }
+    _searchThread.join();
+    _pondering = false;
+    SearchInfo info;
+    while (_searchProgress.pop(info)) {
+    }
+}
 
-    _bitboards[BLACK_ALL_PIECES] = _bitboards[BLACK_PAWNS].getData() | _bitboards[BLACK_KNIGHTS].getData() | _bitboards[BLACK_BISHOPS].getData() |
-                                   _bitboards[BLACK_ROOKS].getData() | _bitboards[BLACK_QUEENS].getData() | _bitboards[BLACK_KING].getData();
-    
-    _bitboards[OCCUPANCY] = _bitboards[WHITE_ALL_PIECEES].getData() | _bitboards[BLACK_ALL_PIECES].getData();
-    int bitIndex = playerColor == WHITE ? WHITE_PAWNS : BLACK_PAWNS;
-    // Friendly and enemy aggregate bitboards
-    uint64_t occupancyData = _bitboards[OCCUPANCY].getData();
-    uint64_t friendlyData = (playerColor == WHITE) ? _bitboards[WHITE_ALL_PIECEES].getData() : _bitboards[BLACK_ALL_PIECES].getData();
-    uint64_t enemyData = (playerColor == WHITE) ? _bitboards[BLACK_ALL_PIECES].getData() : _bitboards[WHITE_ALL_PIECEES].getData();
-    BitBoard emptySquares(~occupancyData);
-
-    generateKnightMoves(moves, _bitboards[WHITE_KNIGHTS + bitIndex], emptySquares.getData());
-    generateKingMoves(moves, _bitboards[WHITE_KING + bitIndex], ~friendlyData);
-    generateBishopMoves(moves, _bitboards[WHITE_BISHOPS + bitIndex], occupancyData, friendlyData);
-    generatePawnMoveList(moves, _bitboards[WHITE_PAWNS + bitIndex], BitBoard(emptySquares.getData()), BitBoard(enemyData), playerColor);
-    generateRookMoves(moves, _bitboards[WHITE_ROOKS + bitIndex], occupancyData, friendlyData);
-    generateQueenMoves(moves, _bitboards[WHITE_QUEENS + bitIndex], occupancyData, friendlyData);
-    return moves;
+std::string Chess::searchInfoString()
+{
+    const SearchInfo& info = _lastSearchInfo;
+    std::string state = _pondering ? "AI pondering " + moveToString(_ponderMove) : (isSearching() ? "AI thinking" : "AI searched");
+    if (info.depth == 0) {
+        return isSearching() ? state + "..." : "";
+    }
+    std::stringstream ss;
+    ss << state << " depth " << info.depth << " score " << info.score
+       << " nodes " << info.nodes << " (" << info.nodes * 1000 / std::max<int64_t>(info.timeMs, 1) << " nps) hash " << info.hashfull << "\n";
+    ss << "pv";
+    for (int i = 0; i < info.pvLength; i++) {
+        ss << " " << moveToString(info.pv[i]);
+    }
+    return ss.str();
 }
 
-void Chess::updateAI() {
-    int bestVal = negInfite;
-    BitMove bestMove;
-    std::string state = stateString();
-
-    for(auto move : _moves) {
-        int srcSquare = move.from;
-        int dstSquare = move.to;
-        
-        char oldDst = state[dstSquare];
-        char srcPece = state[srcSquare];
-        state[dstSquare] = state[srcSquare];
-        state[dstSquare] = state[srcSquare];
-        state[srcSquare] = '0';
-        int moveVal = -negamax(state, 3, negInfite, posInfite, HUMAN_PLAYER);
-        
-        state[dstSquare] = oldDst;
-        state[srcSquare] = srcPece;
-        if(moveVal > bestVal) {
-            bestMove = move;
-            bestVal = moveVal;
+void Chess::playSearchResult(const SearchResult& result)
+{
+    if (_gameOptions.AIClockMs > 0) {
+        _gameOptions.AIClockMs = std::max(_gameOptions.AIClockMs - (int)result.timeMs, 0) + _gameOptions.AIIncrementMs;
+        if (_gameOptions.AIMovesToGo > 0) {
+            _gameOptions.AIMovesToGo--;
         }
-    };
-
+    }
 
     // Make the best move
-    if(bestVal != negInfite) {
-       std::cout << "Moves checked: " << _countMoves << std::endl;
+    if(!result.bestMove.isNone()) {
+       std::cout << "Moves checked: " << result.nodes << " threads: " << _search.threads() << " hashfull: " << _search.hashfull() << std::endl;
 
-       int srcSquare = bestMove.from;
-       int dstSquare = bestMove.to;
+       int srcSquare = result.bestMove.from();
+       int dstSquare = result.bestMove.to();
        BitHolder& src = getHolderAt(srcSquare&7, srcSquare/8);
         BitHolder& dst = getHolderAt(dstSquare&7, dstSquare/8);
         Bit* bit = src.bit();
         dst.dropBitAtPoint(bit, ImVec2(0,0));
         src.setBit(nullptr);
-        bitMovedFromTo(*bit, src, dst);
-
-    }
-}
+        playMove(result.bestMove);
 
-int Chess::negamax(std::string& state, int depth, int alpha, int beta, int playerColor) 
-{
-    
-    _countMoves++;
-    if(depth == 0) {
-        return evaluateBoard(state);
-    }
-
-    auto newMoves = generateAllMoves(state, playerColor);
-    
-    
-    int bestVal = negInfite; // Min value
-    for(auto move : newMoves) {
-        char  boardSave = state[move.to];
-        char pieceMoving = state[move.from];
-
-        state[move.to] = pieceMoving;
-        state[move.from] = '0';
-        bestVal = std::max(bestVal, -negamax(state, depth - 1, -beta, -alpha, -playerColor));
-
-        state[move.from] = pieceMoving;
-        state[move.to] = boardSave;
-        alpha = std::max(alpha, bestVal);
-        if(alpha >= beta) {
-            break; // Beta cutoff
+        // think on the opponent's time about the reply the search expects
+        if (_gameOptions.AIPonder && !_gameOptions.AIvsAI && result.pvLength >= 2) {
+            startPondering(result.pv[1]);
         }
-    };
-
-    return bestVal;
-}
-
-#define FLIP(x) (x^56)
-
-int Chess::evaluateBoard(const std::string& state) {
-    int values[128];
-    values['P'] = 10; values['p'] = -10;
-    values['N'] = 30; values['n'] = -30;
-    values['B'] = 30; values['b'] = -30;
-    values['R'] = 50; values['r'] = -50;
-    values['Q'] = 90; values['q'] = -90;
-    values['K'] = 900; values['k'] = -900;
-    values['0'] = 0;
-
-    int score = 0;
-    int square = 0;
-    for (char ch: state) {
-        score += values[ch];
-        bool isWhite = isupper(ch);
-        switch(ch) {
-            case 'P':    
-            case 'p':
-                score += isWhite ? PawnTableMid[FLIP(square)] : -PawnTableMid[square];
-                break;
-            case 'N':
-            case 'n':
-                score += isWhite ? KnightTableMid[FLIP(square)] : -KnightTableMid[square];
-                break;
-            case 'B':
-            case 'b':
-                score += isWhite ? bishopTable[FLIP(square)] : -bishopTable[square];
-                break;
-            case 'R':
-            case 'r':
-                score += isWhite ? rookTable[FLIP(square)] : -rookTable[square];
-                break;
-            case 'Q':
-            case 'q':
-                score += isWhite ? queenTable[FLIP(square)] : -queenTable[square];
-                break;
-            case 'K':
-            case 'k':
-                score += isWhite ? kingTable[FLIP(square)] : -kingTable[square];
-                break;
-            
-        }
-        square++;
     }
-
-    return score;
-}
\ No newline at end of file
+}
@@ -0,0 +1,256 @@
+#include "Evaluate.h"
+#include "MagicBitboards.h"
+#include "PawnTable.h"
+#include <algorithm>
+#ifdef EVAL_DEBUG
+#include <cstdlib>
+#include <iostream>
+#endif
+
+// pawn structure terms, by the pawn's rank counted from its own side for passers
+constexpr Score PassedPawn[8] = {
+    makeScore(0, 0), makeScore(5, 10), makeScore(10, 15), makeScore(15, 25),
+    makeScore(30, 50), makeScore(50, 90), makeScore(80, 140), makeScore(0, 0)
+};
+constexpr Score IsolatedPawn = makeScore(-10, -15);
+constexpr Score DoubledPawn = makeScore(-10, -25);
+constexpr Score BackwardPawn = makeScore(-8, -10);
+// king shelter, middlegame only: by how far the nearest own pawn on each of the
+// king's files stands in front of it (1, 2, further or none)
+constexpr int ShelterPenalty[4] = { 0, 0, -10, -25 };
+
+#ifndef EVAL_NO_ACTIVITY
+// mobility, by ChessPiece: per square a piece attacks that isn't its own side's
+// or covered by an enemy pawn, counted from a typical number of squares so an
+// average piece scores about nothing
+constexpr Score MobilityBonus[7] = {
+    0, 0, makeScore(4, 4), makeScore(5, 5), makeScore(2, 4), makeScore(1, 2), 0
+};
+constexpr int MobilityCenter[7] = { 0, 0, 4, 6, 7, 13, 0 };
+// king safety: attack units per square of the enemy king zone a piece hits, by
+// ChessPiece. once two or more pieces take part the attacker gets units squared
+// (over KingDangerDivisor), mostly in the middlegame
+constexpr int KingAttackWeight[7] = { 0, 0, 2, 2, 3, 5, 0 };
+constexpr int KingDangerDivisor = 2;
+constexpr int MaxKingDanger = 500;
+// threats, for the attacking side: a piece of the enemy's (not a pawn or the king)
+// that nothing defends, and ones attacked by something cheaper, by its ChessPiece
+constexpr Score HangingPiece = makeScore(30, 20);
+constexpr Score ThreatByPawn[7] = { 0, 0, makeScore(50, 40), makeScore(50, 40), makeScore(70, 50), makeScore(80, 60), 0 };
+constexpr Score ThreatByMinor[7] = { 0, 0, 0, 0, makeScore(40, 30), makeScore(50, 40), 0 };
+constexpr Score ThreatByRook = makeScore(40, 30);
+#endif
+
+static uint64_t northFill(uint64_t bits)
+{
+    bits |= bits << 8;
+    bits |= bits << 16;
+    bits |= bits << 32;
+    return bits;
+}
+
+static uint64_t southFill(uint64_t bits)
+{
+    bits |= bits >> 8;
+    bits |= bits >> 16;
+    bits |= bits >> 32;
+    return bits;
+}
+
+// the squares ahead of every pawn (not its own) and behind it, from its side's point of view
+static uint64_t frontSpan(uint64_t pawns, int side) { return side == WHITE ? NORTH(northFill(pawns)) : SOUTH(southFill(pawns)); }
+static uint64_t rearSpan(uint64_t pawns, int side) { return frontSpan(pawns, -side); }
+static uint64_t pawnAttacks(uint64_t pawns, int side) { return side == WHITE ? WHITE_PAWN_ATTACKS(pawns) : BLACK_PAWN_ATTACKS(pawns); }
+
+// side's pawn terms, and its passed pawns
+static Score pawnStructure(uint64_t pawns, uint64_t enemyPawns, int side, uint64_t& passed)
+{
+    Score score = 0;
+    uint64_t files = northFill(pawns) | southFill(pawns);
+    uint64_t neighbours = EAST(files) | WEST(files);
+
+    // nothing of the enemy's ahead on the same or a neighbouring file can stop or take it,
+    // and for doubled pawns only the front one counts
+    uint64_t enemyFront = frontSpan(enemyPawns, -side);
+    passed = pawns & ~(enemyFront | EAST(enemyFront) | WEST(enemyFront)) & ~rearSpan(pawns, side);
+    for (uint64_t bits = passed; bits; bits &= bits - 1) {
+        int rank = getFirstBit(bits) / 8;
+        score += PassedPawn[side == WHITE ? rank : 7 - rank];
+    }
+
+    score += IsolatedPawn * countOnes(pawns & ~neighbours);
+    score += DoubledPawn * countOnes(pawns & rearSpan(pawns, side));
+
+    // the square in front is covered by an enemy pawn and no own pawn can ever cover it
+    uint64_t stops = side == WHITE ? NORTH(pawns) : SOUTH(pawns);
+    uint64_t supportable = pawnAttacks(side == WHITE ? northFill(pawns) : southFill(pawns), side);
+    uint64_t backwardStops = stops & pawnAttacks(enemyPawns, -side) & ~supportable;
+    score += BackwardPawn * countOnes(side == WHITE ? SOUTH(backwardStops) : NORTH(backwardStops));
+    return score;
+}
+
+static int kingShelter(uint64_t pawns, int kingSquare, int side)
+{
+    int kingFile = kingSquare % 8;
+    int kingRank = kingSquare / 8;
+    int shelter = 0;
+    for (int file = std::max(kingFile - 1, 0); file <= std::min(kingFile + 1, 7); file++) {
+        uint64_t filePawns = pawns & (0x0101010101010101ULL << file);
+        // ahead of the king, the nearest first
+        int distance = 3;
+        for (uint64_t bits = filePawns; bits; bits &= bits - 1) {
+            int ahead = (getFirstBit(bits) / 8 - kingRank) * side;
+            if (ahead > 0) {
+                distance = std::min(distance, ahead);
+            }
+        }
+        shelter += ShelterPenalty[distance];
+    }
+    return shelter;
+}
+
+// pawn structure plus both kings' shelter, from white's point of view
+static Score pawnScore(const Position& position, PawnTable* pawnTable)
+{
+    // a missing king never gets its shelter scored, it has to start out at nothing
+    PawnEntry local{};
+    PawnEntry* entry = &local;
+    bool hit = false;
+    if (pawnTable) {
+        entry = &pawnTable->probe(position.pawnKey(), hit);
+    } else {
+        local.kingSquare[0] = local.kingSquare[1] = PawnTable::NoKingSquare;
+    }
+    uint64_t whitePawns = position.pieces(WHITE_PAWNS);
+    uint64_t blackPawns = position.pieces(BLACK_PAWNS);
+    if (!hit) {
+        entry->key = position.pawnKey();
+        entry->structure = pawnStructure(whitePawns, blackPawns, WHITE, entry->passed[0])
+                         - pawnStructure(blackPawns, whitePawns, BLACK, entry->passed[1]);
+    }
+
+    for (int color = 0; color < 2; color++) {
+        int side = color == 0 ? WHITE : BLACK;
+        int kingSquare = position.kingSquare(side);
+        if (kingSquare != entry->kingSquare[color]) {
+            entry->kingSquare[color] = (uint8_t)kingSquare;
+            // a missing king has no shelter to score
+            entry->shelter[color] = kingSquare == NO_SQUARE ? 0
+                                  : (int16_t)kingShelter(side == WHITE ? whitePawns : blackPawns, kingSquare, side);
+        }
+    }
+    return entry->structure + makeScore(entry->shelter[0] - entry->shelter[1], 0);
+}
+
+#ifndef EVAL_NO_ACTIVITY
+// squares each side attacks, by ChessPiece (index 0 is everything), built once per
+// evaluation while the activity terms go through every piece's own attack set
+struct AttackMaps
+{
+    uint64_t by[2][7];
+};
+
+// mobility and attacks on the enemy king zone for one side's pieces, filling in
+// the side's attack maps on the way. the enemy's pawn attacks have to be in already
+static Score pieceActivity(const Position& position, int side, AttackMaps& attacks)
+{
+    int color = side == WHITE ? 0 : 1;
+    uint64_t occupied = position.occupancy();
+    uint64_t own = position.pieces(side == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES);
+    uint64_t mobilityArea = ~own & ~attacks.by[1 - color][Pawn];
+    // positions set up without a king have no king zone to attack
+    int enemyKing = position.kingSquare(-side);
+    uint64_t kingZone = enemyKing == NO_SQUARE ? 0 : KingAttacks[enemyKing] | (1ULL << enemyKing);
+
+    Score score = 0;
+    int kingAttackers = 0;
+    int kingAttackUnits = 0;
+    for (int type = Knight; type <= Queen; type++) {
+        for (uint64_t pieces = position.pieces(pieceIndexFor((ChessPiece)type, side)); pieces; pieces &= pieces - 1) {
+            int square = getFirstBit(pieces);
+            uint64_t targets = type == Knight ? KnightAttacks[square]
+                             : type == Bishop ? getBishopAttacks(square, occupied)
+                             : type == Rook ? getRookAttacks(square, occupied)
+                             : getQueenAttacks(square, occupied);
+            attacks.by[color][type] |= targets;
+            score += MobilityBonus[type] * (countOnes(targets & mobilityArea) - MobilityCenter[type]);
+            if (uint64_t zoneHits = targets & kingZone) {
+                kingAttackers++;
+                kingAttackUnits += KingAttackWeight[type] * countOnes(zoneHits);
+            }
+        }
+    }
+    int ownKing = position.kingSquare(side);
+    attacks.by[color][King] = ownKing == NO_SQUARE ? 0 : KingAttacks[ownKing];
+    for (int type = Pawn; type <= King; type++) {
+        attacks.by[color][0] |= attacks.by[color][type];
+    }
+
+    // a lone attacker is rarely dangerous, the danger grows with the pile-up
+    if (kingAttackers >= 2) {
+        int danger = std::min(kingAttackUnits * kingAttackUnits / KingDangerDivisor, MaxKingDanger);
+        score += makeScore(danger, danger / 8);
+    }
+    return score;
+}
+
+// side's threats against the enemy's pieces, from the finished attack maps
+static Score threats(const Position& position, int side, const AttackMaps& attacks)
+{
+    int color = side == WHITE ? 0 : 1;
+    const uint64_t* ours = attacks.by[color];
+    const uint64_t* theirs = attacks.by[1 - color];
+    Score score = 0;
+    for (int type = Knight; type <= Queen; type++) {
+        uint64_t targets = position.pieces(pieceIndexFor((ChessPiece)type, -side));
+        score += HangingPiece * countOnes(targets & ours[0] & ~theirs[0]);
+        score += ThreatByPawn[type] * countOnes(targets & ours[Pawn]);
+        score += ThreatByMinor[type] * countOnes(targets & (ours[Knight] | ours[Bishop]));
+        if (type == Queen) {
+            score += ThreatByRook * countOnes(targets & ours[Rook]);
+        }
+    }
+    return score;
+}
+
+// mobility, king safety and threats, from white's point of view
+static Score activityScore(const Position& position)
+{
+    AttackMaps attacks = {};
+    attacks.by[0][Pawn] = pawnAttacks(position.pieces(WHITE_PAWNS), WHITE);
+    attacks.by[1][Pawn] = pawnAttacks(position.pieces(BLACK_PAWNS), BLACK);
+    Score score = pieceActivity(position, WHITE, attacks) - pieceActivity(position, BLACK, attacks);
+    return score + threats(position, WHITE, attacks) - threats(position, BLACK, attacks);
+}
+#endif
+
+int evaluateBoard(const Position& position, PawnTable* pawnTable) {
+#ifdef EVAL_DEBUG
+    Score recounted = position.computePsqt();
+    int recountedPhase = position.computePhase();
+    if (position.psqtScore() != recounted || position.phase() != recountedPhase
+        || position.pawnKey() != position.computePawnKey()) {
+        std::cerr << "incremental eval " << position.psqtScore() << " phase " << position.phase()
+                  << " != recount " << recounted << " phase " << recountedPhase
+                  << " (or the pawn key is off) in " << position.stateString() << "\n";
+        std::abort();
+    }
+#endif
+    // probed once, the table's hit rate counts evaluations
+    Score pawns = pawnScore(position, pawnTable);
+#ifdef EVAL_DEBUG
+    // a cached pawn evaluation has to match a fresh one
+    if (pawnTable && pawns != pawnScore(position, nullptr)) {
+        std::cerr << "pawn table entry differs from a recount in " << position.stateString() << "\n";
+        std::abort();
+    }
+#endif
+    Score score = position.psqtScore() + pawns;
+#ifndef EVAL_NO_ACTIVITY
+    score += activityScore(position);
+#endif
+    // promotions can push the phase past the starting material
+    int phase = std::min(position.phase(), PhaseTotal);
+    int eg = egValue(score);
+    return eg + (mgValue(score) - eg) * phase / PhaseTotal;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Position.h"
+#include "PieceSquare.h"
+
+// material by ChessPiece, in evaluation units (centipawns, middlegame values),
+// for exchanges and move ordering
+inline constexpr int PieceValues[7] = { 0, PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE };
+
+//
+// a middlegame and an endgame value packed in one int, endgame in the high 16 bits,
+// so adding two scores adds both halves at once. the low half is signed, the +0x8000
+// in egValue undoes the borrow a negative middlegame value takes from the high half
+//
+using Score = int;
+
+constexpr Score makeScore(int mg, int eg) { return (Score)((unsigned)eg << 16) + mg; }
+constexpr int mgValue(Score score) { return (int16_t)(uint16_t)(unsigned)score; }
+constexpr int egValue(Score score) { return (int16_t)(uint16_t)((unsigned)(score + 0x8000) >> 16); }
+
+// game phase from the non-pawn material left: 24 with every minor and major piece
+// on the board, 0 with none. blending runs from the middlegame score at 24 to the
+// endgame one at 0
+inline constexpr int PhaseWeights[7] = { 0, 0, 1, 1, 2, 4, 0 };
+constexpr int PhaseTotal = 24;
+
+//
+// material plus piece-square bonus for every piece (WHITE_PAWNS..BLACK_KING) on
+// every square, middlegame and endgame, from white's point of view, generated at
+// compile time. the tables in PieceSquare.h are drawn for white from the 8th rank
+// down, so white flips them
+//
+struct PsqtTable
+{
+    Score score[12][64];
+};
+
+constexpr PsqtTable makePsqtTable()
+{
+    PsqtTable psqt{};
+    const int* mgTables[7] = { nullptr, PawnTableMid, KnightTableMid, bishopTable, rookTable, queenTable, kingTable };
+    const int* egTables[7] = { nullptr, PawnTableEnd, KnightTableEnd, bishopTableEnd, rookTableEnd, queenTableEnd, kingTableEnd };
+    // the kings' material cancels out, leave it out so the halves stay small
+    const int mgValues[7] = { 0, PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, 0 };
+    const int egValues[7] = { 0, PAWN_VALUE_END, KNIGHT_VALUE_END, BISHOP_VALUE_END, ROOK_VALUE_END, QUEEN_VALUE_END, 0 };
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+        int type = pieceTypeOf(piece);
+        for (int square = 0; square < 64; square++) {
+            if (pieceColorOf(piece) == WHITE) {
+                psqt.score[piece][square] = makeScore(mgValues[type] + mgTables[type][square ^ 56],
+                                                      egValues[type] + egTables[type][square ^ 56]);
+            } else {
+                psqt.score[piece][square] = makeScore(-mgValues[type] - mgTables[type][square],
+                                                      -egValues[type] - egTables[type][square]);
+            }
+        }
+    }
+    return psqt;
+}
+
+inline constexpr PsqtTable Psqt = makePsqtTable();
+
+class PawnTable;
+
+// static evaluation in centipawns from white's point of view. material and
+// piece-square terms and the phase come from the position's running totals, pawn
+// structure and king shelter from pawnTable when there is one (each search thread
+// has its own). mobility, king attacks and threats come from every piece's attack
+// set, built once per call; building with EVAL_NO_ACTIVITY leaves them out, to
+// weigh their cost against the depth it takes. building with EVAL_DEBUG checks the
+// running totals against a full recount on every call
+int evaluateBoard(const Position& position, PawnTable* pawnTable = nullptr);
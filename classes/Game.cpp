@@ -15,6 +15,13 @@ Game::Game()
 	_gameOptions.rowY = 0;
 	_gameOptions.score = 0;
 	_gameOptions.AIDepthSearches = 0;
+	_gameOptions.AIMAXDepth = 0;
+	_gameOptions.AIHashSizeMB = 16;
+	_gameOptions.AIThreads = 1;
+	_gameOptions.AIClockMs = 0;
+	_gameOptions.AIIncrementMs = 0;
+	_gameOptions.AIMovesToGo = 0;
+	_gameOptions.AIPonder = false;
 	_gameOptions.AIvsAI = false;
 
 	_table = nullptr;
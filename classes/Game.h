@@ -39,8 +39,14 @@ struct GameOptions
 	int gameNumber;
 	unsigned int currentTurnNo;
 	int score;
-	int AIDepthSearches;
-	int AIMAXDepth;
+	int AIDepthSearches;	// the soft deadline doesn't end a search before this depth, the hard one still does
+	int AIMAXDepth;			// and never goes past this one (0 = no cap)
+	int AIHashSizeMB;
+	int AIThreads;			// search threads (lazy SMP), 1 = single threaded
+	int AIClockMs;			// AI's remaining clock, 0 = untimed
+	int AIIncrementMs;
+	int AIMovesToGo;		// moves until the next time control, 0 = sudden death
+	bool AIPonder;			// keep searching the expected reply on the opponent's time
 	bool AIvsAI;
 };
 
@@ -95,6 +101,16 @@ public:
 	virtual void stopGame() = 0;
 	virtual bool gameHasAI();
 	virtual void updateAI();
+
+	// asynchronous AI: startSearch kicks the search off and returns at once, poll is called
+	// every frame and plays the AI's move once it is ready (returns true when it did),
+	// stopSearch abandons a running search. the defaults run updateAI synchronously.
+	virtual void startSearch() { updateAI(); }
+	virtual bool poll() { return false; }
+	virtual void stopSearch() {}
+	virtual bool isSearching() const { return false; }
+	// one or more lines describing the running/last search for the settings window
+	virtual std::string searchInfoString() { return ""; }
 	virtual void pieceTaken(Bit *bit){};
 
 	virtual std::string initialStateString() = 0;
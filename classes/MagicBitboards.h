@@ -2,6 +2,14 @@
 #define MAGIC_BITBOARDS_H
 
 #include <stdint.h>
+#include <mutex>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #include <immintrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+    #include <cpuid.h>
+#endif
 
 // Generate rook attacks for a given square and blocking pieces
 static inline uint64_t ratt(int sq, uint64_t block) {
@@ -83,11 +91,12 @@ static inline uint64_t batt(int sq, uint64_t block) {
 
     // Fallback first bit implementation
     static inline int getFirstBit(uint64_t b) {
+        // de Bruijn bit scan, the table has to match the multiplier and the b ^ (b-1) mask
         const int BitTable[64] = {
-            63, 30, 3, 32, 25, 41, 22, 33, 15, 50, 42, 13, 11, 53, 19, 34,
-            61, 29, 2, 51, 21, 43, 45, 10, 18, 47, 1, 54, 9, 57, 0, 35,
-            62, 31, 40, 4, 49, 5, 52, 26, 60, 6, 23, 44, 46, 27, 56, 16,
-            7, 39, 48, 24, 59, 14, 12, 55, 38, 28, 58, 20, 37, 17, 36, 8
+             0, 47,  1, 56, 48, 27,  2, 60, 57, 49, 41, 37, 28, 16,  3, 61,
+            54, 58, 35, 52, 50, 42, 21, 44, 38, 32, 29, 23, 17, 11,  4, 62,
+            46, 55, 26, 59, 40, 36, 15, 53, 34, 51, 20, 43, 31, 22, 10, 45,
+            25, 39, 14, 33, 19, 30,  9, 24, 13, 18,  8, 12,  7,  6,  5, 63
         };
         uint64_t debruijn = 0x03f79d71b4cb0a89ULL;
         return BitTable[((b ^ (b-1)) * debruijn) >> 58];
@@ -262,9 +271,16 @@ const int BAttackSize[64] = {
   64,
 };
 
-// Attack lookup tables
-static uint64_t* RAttacks[64];
-static uint64_t* BAttacks[64];
+// Total entries over all squares, every square's table packed one after the other
+constexpr int sliderTableSize(const int* sizes) {
+    int total = 0;
+    for (int square = 0; square < 64; square++) {
+        total += sizes[square];
+    }
+    return total;
+}
+constexpr int RookTableSize = sliderTableSize(RAttackSize);
+constexpr int BishopTableSize = sliderTableSize(BAttackSize);
 
 // Magic bitboard shift amounts
 const int RShifts[64] = {
@@ -808,66 +824,147 @@ const uint64_t KingAttacks[64] = {
   0x40c0000000000000ULL,
 };
 
+// How slider attack tables are indexed. PEXT packs the mask bits of the occupancy
+// straight into an index, with no magic constants and no multiply/shift. The
+// tables are the same size either way, so the choice only changes how they're filled
+enum SliderBackend { SLIDERS_MAGIC, SLIDERS_PEXT };
+inline SliderBackend SliderIndexing = SLIDERS_MAGIC;
+
+static inline const char* sliderBackendName(SliderBackend backend) {
+    return backend == SLIDERS_PEXT ? "pext" : "magic";
+}
+
+// Parallel bit extract. Only called once the CPU is known to have BMI2, so the
+// compiler doesn't need to be told to target it (inline asm instead of the intrinsic)
+static inline uint64_t pext(uint64_t value, uint64_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+    return _pext_u64(value, mask);
+#elif defined(__x86_64__)
+    uint64_t result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+    return result;
+#else
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (value & mask & -mask) {
+            result |= bit;
+        }
+        mask &= mask - 1;
+    }
+    return result;
+#endif
+}
+
+#if (defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)) || defined(__x86_64__)
+    #define SLIDERS_HAVE_CPUID 1
+// eax, ebx, ecx, edx of cpuid leaf/subleaf
+static inline void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int out[4];
+    __cpuidex(out, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = (unsigned)out[i];
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+#endif
+
+// BMI2 is there and PEXT is fast. AMD before Zen 3 (family 19h) runs it in
+// microcode, dozens of cycles a go, where the magic multiply wins
+static inline bool cpuHasFastPext() {
+#ifdef SLIDERS_HAVE_CPUID
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) {
+        return false;
+    }
+    bool amd = regs[1] == 0x68747541; // "Auth"enticAMD
+    cpuid(7, 0, regs);
+    bool bmi2 = (regs[1] >> 8) & 1;
+    cpuid(1, 0, regs);
+    unsigned family = (regs[0] >> 8) & 0xf;
+    if (family == 0xf) {
+        family += (regs[0] >> 20) & 0xff;
+    }
+    return bmi2 && !(amd && family < 0x19);
+#else
+    return false;
+#endif
+}
+
+static inline SliderBackend bestSliderBackend() {
+    return cpuHasFastPext() ? SLIDERS_PEXT : SLIDERS_MAGIC;
+}
+
+// Everything one lookup needs for a square, side by side ("fancy" magics): the
+// attacks are a slice of one contiguous table starting at offset
+struct SliderMagic {
+    uint64_t mask;
+    uint64_t magic;
+    uint32_t offset;
+    uint32_t shift;
+};
+
+// Attack lookup tables, one contiguous cache aligned block for the whole process,
+// rooks first, then bishops. Built once by initMagicBitboards and only read after
+alignas(64) inline uint64_t SliderAttacks[RookTableSize + BishopTableSize];
+alignas(64) inline SliderMagic RookMagics[64];
+alignas(64) inline SliderMagic BishopMagics[64];
+inline std::once_flag SliderTablesBuilt;
+
+static inline uint64_t sliderIndex(const SliderMagic& entry, uint64_t occupied) {
+    if (SliderIndexing == SLIDERS_PEXT) {
+        return pext(occupied, entry.mask);
+    }
+    return ((occupied & entry.mask) * entry.magic) >> entry.shift;
+}
+
 // Helper functions for move generation
 static inline uint64_t getRookAttacks(int square, uint64_t occupied) {
-    occupied &= RMasks[square];
-    occupied *= RMagic[square];
-    occupied >>= RShifts[square];
-    return RAttacks[square][occupied];
+    const SliderMagic& entry = RookMagics[square];
+    return SliderAttacks[entry.offset + sliderIndex(entry, occupied)];
 }
 
 static inline uint64_t getBishopAttacks(int square, uint64_t occupied) {
-    occupied &= BMasks[square];
-    occupied *= BMagic[square];
-    occupied >>= BShifts[square];
-    return BAttacks[square][occupied];
+    const SliderMagic& entry = BishopMagics[square];
+    return SliderAttacks[entry.offset + sliderIndex(entry, occupied)];
 }
 
 static inline uint64_t getQueenAttacks(int square, uint64_t occupied) {
     return getRookAttacks(square, occupied) | getBishopAttacks(square, occupied);
 }
 
-// Initialize magic bitboards
-void initMagicBitboards(void) {
-    int square, i;
-    uint64_t subset, index;
-
-    // Initialize rook attack tables
-    for (square = 0; square < 64; square++) {
-        RAttacks[square] = new uint64_t[RAttackSize[square]];
-        uint64_t mask = RMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * RMagic[square]) >> RShifts[square];
-            RAttacks[square][index] = ratt(square, subset);
-        }
-    }
-
-    // Initialize bishop attack tables
-    for (square = 0; square < 64; square++) {
-        BAttacks[square] = new uint64_t[BAttackSize[square]];
-        uint64_t mask = BMasks[square];
-        int bits = countOnes(mask);
-        int n = 1 << bits;
-
-        for (i = 0; i < n; i++) {
-            subset = indexToUint64(i, bits, mask);
-            index = (subset * BMagic[square]) >> BShifts[square];
-            BAttacks[square][index] = batt(square, subset);
+// Fills one piece type's slices of the table, offset is where its first square's goes
+static inline void buildSliderTables(SliderMagic* magics, const uint64_t* masks, const uint64_t* magicNumbers,
+                                     const int* shifts, const int* sizes, uint32_t offset,
+                                     uint64_t (*attacks)(int, uint64_t)) {
+    for (int square = 0; square < 64; square++) {
+        SliderMagic& entry = magics[square];
+        entry.mask = masks[square];
+        entry.magic = magicNumbers[square];
+        entry.shift = shifts[square];
+        entry.offset = offset;
+        offset += sizes[square];
+
+        int bits = countOnes(entry.mask);
+        for (int i = 0; i < (1 << bits); i++) {
+            uint64_t subset = indexToUint64(i, bits, entry.mask);
+            SliderAttacks[entry.offset + sliderIndex(entry, subset)] = attacks(square, subset);
         }
     }
 }
 
-// Cleanup magic bitboard tables
-void cleanupMagicBitboards(void) {
-    int square;
-    for (square = 0; square < 64; square++) {
-        delete[] RAttacks[square];
-        delete[] BAttacks[square];
-    }
+// Builds the slider tables the first time it's called, in any thread, indexed for
+// backend (the fastest one this CPU has by default). Later calls return at once and
+// their backend is ignored, so a tool that wants a particular one has to ask first
+inline void initMagicBitboards(SliderBackend backend = bestSliderBackend()) {
+    std::call_once(SliderTablesBuilt, [backend]() {
+        SliderIndexing = backend;
+        buildSliderTables(RookMagics, RMasks, RMagic, RShifts, RAttackSize, 0, ratt);
+        buildSliderTables(BishopMagics, BMasks, BMagic, BShifts, BAttackSize, RookTableSize, batt);
+    });
 }
 
 #endif // MAGIC_BITBOARDS_H
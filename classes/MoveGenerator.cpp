@@ -0,0 +1,258 @@
+#include "MoveGenerator.h"
+#include "MagicBitboards.h"
+#include "Rays.h"
+
+// one move per promotion piece: the queen is a tactical move, the underpromotions quiet ones
+static inline void addPromotions(MoveList& moves, int fromSquare, int toSquare, bool capture, MoveGenType type)
+{
+    int flags = capture ? KNIGHT_PROMOTION_CAPTURE : KNIGHT_PROMOTION;
+    if (type != QUIETS) {
+        moves.add(fromSquare, toSquare, flags + Queen - Knight);
+    }
+    if (type != CAPTURES) {
+        for (int piece = Rook; piece >= Knight; piece--) {
+            moves.add(fromSquare, toSquare, flags + piece - Knight);
+        }
+    }
+}
+
+// allowed is where a pawn move may end: the check evasion mask, and the pin line for pinned pawns
+static void generatePawnMoveList(MoveList& moves, const BitBoard pawns, const BitBoard emptySquares, const BitBoard enemyPieces, uint64_t allowed, char color, MoveGenType type)
+{
+   if (pawns.getData() == 0) return;
+
+    uint64_t pawnsData = pawns.getData();
+    uint64_t emptyData = emptySquares.getData();
+    uint64_t enemyData = enemyPieces.getData() & allowed;
+    uint64_t promotionRank = (color == WHITE) ? Rank8 : Rank1;
+    // Single forward moves
+    uint64_t singleMovesData = (color == WHITE) ? ((pawnsData << 8) & emptyData) : ((pawnsData >> 8) & emptyData);
+    // Double forward moves from starting rank
+    uint64_t doubleMovesData = (color == WHITE) ? (((singleMovesData & Rank3) << 8) & emptyData) : (((singleMovesData & Rank6) >> 8) & emptyData);
+    singleMovesData &= allowed;
+    doubleMovesData &= allowed;
+
+    BitBoard promotions(singleMovesData & promotionRank);
+    promotions.forEachBit([&](int toSquare) {
+        int fromSquare = (color == WHITE) ? (toSquare - 8) : (toSquare + 8);
+        addPromotions(moves, fromSquare, toSquare, false, type);
+    });
+    if (type != CAPTURES) {
+        BitBoard singleMoves(singleMovesData & ~promotionRank);
+        singleMoves.forEachBit([&](int toSquare) {
+            int fromSquare = (color == WHITE) ? (toSquare - 8) : (toSquare + 8);
+            moves.add(fromSquare, toSquare, QUIET_MOVE);
+        });
+        BitBoard doubleMoves(doubleMovesData);
+        doubleMoves.forEachBit([&](int toSquare) {
+            int fromSquare = (color == WHITE) ? (toSquare - 16) : (toSquare + 16);
+            moves.add(fromSquare, toSquare, DOUBLE_PAWN_PUSH);
+        });
+    }
+
+    // Captures
+    uint64_t capturesLeftData = (color == WHITE) ? (((pawnsData & NotAFile) << 7) & enemyData) : (((pawnsData & NotAFile) >> 9) & enemyData);
+    uint64_t capturesRightData = (color == WHITE) ? (((pawnsData & NotHFile) << 9) & enemyData) : (((pawnsData & NotHFile) >> 7) & enemyData);
+    BitBoard capturesLeft(capturesLeftData);
+    BitBoard capturesRight(capturesRightData);
+
+    capturesLeft.forEachBit([&](int toSquare) {
+        int fromSquare = (color == WHITE) ? (toSquare - 7) : (toSquare + 9);
+        if ((1ULL << toSquare) & promotionRank) {
+            addPromotions(moves, fromSquare, toSquare, true, type);
+        } else if (type != QUIETS) {
+            moves.add(fromSquare, toSquare, CAPTURE);
+        }
+    });
+    capturesRight.forEachBit([&](int toSquare) {
+        int fromSquare = (color == WHITE) ? (toSquare - 9) : (toSquare + 7);
+        if ((1ULL << toSquare) & promotionRank) {
+            addPromotions(moves, fromSquare, toSquare, true, type);
+        } else if (type != QUIETS) {
+            moves.add(fromSquare, toSquare, CAPTURE);
+        }
+    });
+}
+
+// en passant is checked by playing it on the occupancy: taking two pawns off one
+// rank can expose the king sideways, which no pin mask catches
+static void generateEnPassant(MoveList& moves, const Position& position, int kingSquare, uint64_t pawns)
+{
+    int epSquare = position.epSquare();
+    if (epSquare == NO_SQUARE) {
+        return;
+    }
+    int color = position.sideToMove();
+    uint64_t epBit = 1ULL << epSquare;
+    uint64_t capturedBit = color == WHITE ? epBit >> 8 : epBit << 8;
+    uint64_t capturers = (color == WHITE ? BLACK_PAWN_ATTACKS(epBit) : WHITE_PAWN_ATTACKS(epBit)) & pawns;
+    BitBoard(capturers).forEachBit([&](int fromSquare) {
+        uint64_t occupancy = (position.occupancy() ^ (1ULL << fromSquare) ^ capturedBit) | epBit;
+        if ((position.attackersTo(kingSquare, occupancy) & position.enemies() & ~capturedBit) == 0) {
+            moves.add(fromSquare, epSquare, EN_PASSANT);
+        }
+    });
+}
+
+// one move per target square, flagged as a capture when it lands on an enemy piece
+static inline void addMoves(MoveList& moves, int fromSquare, uint64_t toSquares, uint64_t enemies)
+{
+    BitBoard(toSquares & enemies).forEachBit([&](int toSquare) {
+        moves.add(fromSquare, toSquare, CAPTURE);
+    });
+    BitBoard(toSquares & ~enemies).forEachBit([&](int toSquare) {
+        moves.add(fromSquare, toSquare, QUIET_MOVE);
+    });
+}
+
+// a pinned piece may only move along the line through its king and the pinner
+static inline uint64_t pinMask(int fromSquare, uint64_t pinned, int kingSquare)
+{
+    return (pinned >> fromSquare) & 1 ? Rays.line[kingSquare][fromSquare] : ~0ULL;
+}
+
+// Generate actual move objects from a bitboard, pinned knights never move so they aren't passed in
+static void generateKnightMoves(MoveList& moves, BitBoard knightBoard, uint64_t targets, uint64_t enemies) {
+    knightBoard.forEachBit([&](int fromSquare) {
+        BitBoard moveBitboard = BitBoard(KnightAttacks[fromSquare] & targets);
+        addMoves(moves, fromSquare, moveBitboard.getData(), enemies);
+    });
+}
+
+// the king moves only to squares nothing attacks once it has left its own (so it can't
+// step back along a checking ray), and castles only out of check through safe squares
+static void generateKingMoves(MoveList& moves, const Position& position, int kingSquare, uint64_t targets, uint64_t checkers, MoveGenType type) {
+    uint64_t enemies = position.enemies();
+    uint64_t occupancy = position.occupancy() ^ (1ULL << kingSquare);
+    BitBoard moveBitboard = BitBoard(KingAttacks[kingSquare] & targets);
+    moveBitboard.forEachBit([&](int toSquare) {
+        if ((position.attackersTo(toSquare, occupancy) & enemies) == 0) {
+            moves.add(kingSquare, toSquare, (enemies >> toSquare) & 1 ? CAPTURE : QUIET_MOVE);
+        }
+    });
+
+    if (type == CAPTURES || checkers) {
+        return;
+    }
+    auto safe = [&](int square) {
+        return (position.attackersTo(square, position.occupancy()) & enemies) == 0;
+    };
+    int rights = position.castlingRights();
+    int rook = pieceIndexFor(Rook, position.sideToMove());
+    bool white = position.sideToMove() == WHITE;
+    int kingSide = white ? WHITE_OO : BLACK_OO;
+    int queenSide = white ? WHITE_OOO : BLACK_OOO;
+    // the rights can only be set while king and rook are on their home squares
+    if ((rights & kingSide) && position.pieceAt(kingSquare + 3) == rook &&
+        (Rays.between[kingSquare][kingSquare + 3] & position.occupancy()) == 0 &&
+        safe(kingSquare + 1) && safe(kingSquare + 2)) {
+        moves.add(kingSquare, kingSquare + 2, KING_CASTLE);
+    }
+    if ((rights & queenSide) && position.pieceAt(kingSquare - 4) == rook &&
+        (Rays.between[kingSquare][kingSquare - 4] & position.occupancy()) == 0 &&
+        safe(kingSquare - 1) && safe(kingSquare - 2)) {
+        moves.add(kingSquare, kingSquare - 2, QUEEN_CASTLE);
+    }
+}
+
+
+static void generateBishopMoves(MoveList& moves, BitBoard bishopBoard, uint64_t occupancy, uint64_t targets, uint64_t enemies, uint64_t pinned, int kingSquare) {
+    bishopBoard.forEachBit([&](int fromSquare) {
+        BitBoard moveBitboard = BitBoard(getBishopAttacks(fromSquare, occupancy) & targets & pinMask(fromSquare, pinned, kingSquare));
+        addMoves(moves, fromSquare, moveBitboard.getData(), enemies);
+    });
+}
+
+static void generateRookMoves(MoveList& moves, BitBoard rookBoard, uint64_t occupancy, uint64_t targets, uint64_t enemies, uint64_t pinned, int kingSquare) {
+    rookBoard.forEachBit([&](int fromSquare) {
+        BitBoard moveBitboard = BitBoard(getRookAttacks(fromSquare, occupancy) & targets & pinMask(fromSquare, pinned, kingSquare));
+        addMoves(moves, fromSquare, moveBitboard.getData(), enemies);
+    });
+}
+
+static void generateQueenMoves(MoveList& moves, BitBoard queenBoard, uint64_t occupancy, uint64_t targets, uint64_t enemies, uint64_t pinned, int kingSquare) {
+    queenBoard.forEachBit([&](int fromSquare) {
+        BitBoard moveBitboard = BitBoard(getQueenAttacks(fromSquare, occupancy) & targets & pinMask(fromSquare, pinned, kingSquare));
+        addMoves(moves, fromSquare, moveBitboard.getData(), enemies);
+    });
+}
+
+uint64_t pinnedPieces(const Position& position, int kingSquare)
+{
+    int them = -position.sideToMove();
+    uint64_t rooksQueens = position.pieces(pieceIndexFor(Rook, them)) | position.pieces(pieceIndexFor(Queen, them));
+    uint64_t bishopsQueens = position.pieces(pieceIndexFor(Bishop, them)) | position.pieces(pieceIndexFor(Queen, them));
+    // enemy sliders that would see the king on an empty board
+    uint64_t snipers = (getRookAttacks(kingSquare, 0) & rooksQueens) | (getBishopAttacks(kingSquare, 0) & bishopsQueens);
+    uint64_t pinned = 0;
+    BitBoard(snipers).forEachBit([&](int sniper) {
+        uint64_t blockers = Rays.between[kingSquare][sniper] & position.occupancy();
+        // exactly one piece in the way, and it's ours
+        if (blockers && (blockers & (blockers - 1)) == 0) {
+            pinned |= blockers & position.friendlies();
+        }
+    });
+    return pinned;
+}
+
+// the moves of the pieces on fromMask only, the whole side with ~0
+static void generateMoves(const Position& position, MoveGenType type, MoveList& moves, uint64_t fromMask)
+{
+    moves.clear();
+
+    // the position keeps its bitboards up to date, so there is nothing to rebuild here
+    int bitIndex = position.sideToMove() == WHITE ? WHITE_PAWNS : BLACK_PAWNS;
+    int kingSquare = position.kingSquare(position.sideToMove());
+    if (kingSquare == NO_SQUARE) {
+        return;
+    }
+    uint64_t occupancyData = position.occupancy();
+    uint64_t enemyData = position.enemies();
+    uint64_t checkers = position.attackersTo(kingSquare, occupancyData) & enemyData;
+    // squares a move may land on (pawns work theirs out themselves)
+    uint64_t targets = type == CAPTURES ? enemyData : (type == QUIETS ? position.emptySquares() : ~position.friendlies());
+
+    if ((fromMask >> kingSquare) & 1) {
+        generateKingMoves(moves, position, kingSquare, targets, checkers, type);
+    }
+    // in double check only the king can move
+    if (checkers & (checkers - 1)) {
+        return;
+    }
+    // in check everything else has to take the checker or block it
+    uint64_t checkMask = checkers ? (checkers | Rays.between[kingSquare][getFirstBit(checkers)]) : ~0ULL;
+    uint64_t pinned = pinnedPieces(position, kingSquare);
+    targets &= checkMask;
+
+    generateKnightMoves(moves, BitBoard(position.pieces(WHITE_KNIGHTS + bitIndex) & ~pinned & fromMask), targets, enemyData);
+    generateBishopMoves(moves, BitBoard(position.pieces(WHITE_BISHOPS + bitIndex) & fromMask), occupancyData, targets, enemyData, pinned, kingSquare);
+
+    uint64_t pawns = position.pieces(WHITE_PAWNS + bitIndex) & fromMask;
+    BitBoard emptySquares(position.emptySquares());
+    generatePawnMoveList(moves, BitBoard(pawns & ~pinned), emptySquares, BitBoard(enemyData), checkMask, position.sideToMove(), type);
+    BitBoard(pawns & pinned).forEachBit([&](int fromSquare) {
+        generatePawnMoveList(moves, BitBoard(1ULL << fromSquare), emptySquares, BitBoard(enemyData),
+                             checkMask & Rays.line[kingSquare][fromSquare], position.sideToMove(), type);
+    });
+    if (type != QUIETS) {
+        generateEnPassant(moves, position, kingSquare, pawns);
+    }
+
+    generateRookMoves(moves, BitBoard(position.pieces(WHITE_ROOKS + bitIndex) & fromMask), occupancyData, targets, enemyData, pinned, kingSquare);
+    generateQueenMoves(moves, BitBoard(position.pieces(WHITE_QUEENS + bitIndex) & fromMask), occupancyData, targets, enemyData, pinned, kingSquare);
+}
+
+void generateMoves(const Position& position, MoveGenType type, MoveList& moves)
+{
+    generateMoves(position, type, moves, ~0ULL);
+}
+
+bool isLegalMove(const Position& position, const BitMove& move)
+{
+    if (move.isNone() || ((position.friendlies() >> move.from()) & 1) == 0) {
+        return false;
+    }
+    MoveList moves;
+    generateMoves(position, ALL_MOVES, moves, 1ULL << move.from());
+    return moves.contains(move);
+}
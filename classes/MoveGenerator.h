@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Position.h"
+#include "MoveList.h"
+
+constexpr uint64_t NotAFile(0xFEFEFEFEFEFEFEFEULL); //A file mask
+constexpr uint64_t NotHFile(0x7F7F7F7F7F7F7F7FULL); //H file mask
+constexpr uint64_t Rank3(0x0000000000FF0000ULL); //Rank 3 mask
+constexpr uint64_t Rank6(0x0000FF0000000000ULL); //Rank 6 mask
+constexpr uint64_t Rank2(0x000000000000FF00); //Rank 2 mask (white pawns start)
+constexpr uint64_t Rank7(0x00FF000000000000); //Rank 7 mask (black pawns start)
+constexpr uint64_t Rank1(0x00000000000000FFULL); //Rank 1 mask (black promotes)
+constexpr uint64_t Rank8(0xFF00000000000000ULL); //Rank 8 mask (white promotes)
+
+enum MoveGenType
+{
+    ALL_MOVES,
+    CAPTURES,   // captures, en passant and queen promotions, no quiet move is ever produced
+    QUIETS,     // everything CAPTURES leaves out: quiet moves, castling and underpromotions
+    EVASIONS    // every legal move while in check (what ALL_MOVES gives there as well)
+};
+
+// legal moves for the side to move, replacing whatever moves held. checks, pins,
+// castling, en passant and promotions are all handled here, so every move can be
+// played as is. in check only evasions come out. CAPTURES and QUIETS split
+// ALL_MOVES in two, so a caller can generate the quiet moves only when it needs them
+void generateMoves(const Position& position, MoveGenType type, MoveList& moves);
+inline void generateAllMoves(const Position& position, MoveList& moves) { generateMoves(position, ALL_MOVES, moves); }
+inline void generateCaptures(const Position& position, MoveList& moves) { generateMoves(position, CAPTURES, moves); }
+
+// move (a TT move or killer from another position, say) is legal here, flags included.
+// only the moving piece's moves get generated
+bool isLegalMove(const Position& position, const BitMove& move);
+
+// pieces of the side to move that are the only thing between their king and an enemy slider
+uint64_t pinnedPieces(const Position& position, int kingSquare);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "BitBoard.h"
+
+// no legal chess position has more than 218 moves
+constexpr int MAX_MOVES = 256;
+
+//
+// fixed capacity move list that lives wherever it's declared (the search stack,
+// usually), so generating moves never touches the heap.
+//
+class MoveList
+{
+public:
+    MoveList() : _size(0) {}
+
+    void add(int from, int to, int flags) { _moves[_size++] = BitMove(from, to, flags); }
+    void add(const BitMove& move) { _moves[_size++] = move; }
+    void clear() { _size = 0; }
+
+    int size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    BitMove& operator[](int index) { return _moves[index]; }
+    const BitMove& operator[](int index) const { return _moves[index]; }
+
+    BitMove* begin() { return _moves; }
+    BitMove* end() { return _moves + _size; }
+    const BitMove* begin() const { return _moves; }
+    const BitMove* end() const { return _moves + _size; }
+
+    bool contains(const BitMove& move) const
+    {
+        for (int i = 0; i < _size; i++) {
+            if (_moves[i] == move) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    BitMove _moves[MAX_MOVES];
+    int _size;
+};
@@ -0,0 +1,214 @@
+#include "MovePicker.h"
+#include "Evaluate.h"
+#include "StaticExchange.h"
+#include <cstdlib>
+#include <cstring>
+
+// evasions put the captures in a band above anything history can reach
+constexpr int CaptureScore = 1 << 24;
+
+void ButterflyHistory::clear()
+{
+    std::memset(table, 0, sizeof(table));
+}
+
+void ButterflyHistory::update(int side, const BitMove& move, int bonus)
+{
+    int& entry = table[side == WHITE ? 0 : 1][move.from()][move.to()];
+    entry += bonus - entry * std::abs(bonus) / MaxHistory;
+}
+
+void CounterMoves::clear()
+{
+    for (auto& piece : table) {
+        for (auto& move : piece) {
+            move = BitMove::none();
+        }
+    }
+}
+
+// most valuable victim, then least valuable attacker. promotions rank with the
+// captures, by what they add
+static int captureScore(const Position& position, const BitMove& move)
+{
+    int victim = move.isEnPassant() ? (int)Pawn : (move.isCapture() ? (int)pieceTypeOf(position.pieceAt(move.to())) : (int)NoPiece);
+    int value = PieceValues[victim] + (move.isPromotion() ? PieceValues[move.promotionPiece()] - PieceValues[Pawn] : 0);
+    return value * 8 - pieceTypeOf(position.pieceAt(move.from()));
+}
+
+// the moves CAPTURES generates, the ones a capture-only search may get as its TT move
+static bool isTactical(const BitMove& move)
+{
+    return move.isCapture() ? !move.isPromotion() || move.promotionPiece() == Queen : move.promotionPiece() == Queen;
+}
+
+MovePicker::MovePicker(const Position& position, MoveGenType type, BitMove ttMove,
+                       const KillerMoves* killers, const ButterflyHistory* history, BitMove counterMove)
+    : _position(position), _type(type), _stage(TT_MOVE), _ttMove(ttMove), _counterMove(counterMove),
+      _history(history), _index(0), _badIndex(0), _picked(0)
+{
+    _killers[0] = killers ? killers->moves[0] : BitMove::none();
+    _killers[1] = killers ? killers->moves[1] : BitMove::none();
+    if (_type == ALL_MOVES && _position.inCheck()) {
+        _type = EVASIONS;
+    }
+    if (_type == CAPTURES && !isTactical(_ttMove)) {
+        _ttMove = BitMove::none();
+    }
+}
+
+void MovePicker::scoreCaptures()
+{
+    for (int i = 0; i < _moves.size(); i++) {
+        _scores[i] = captureScore(_position, _moves[i]);
+    }
+}
+
+void MovePicker::scoreQuiets()
+{
+    for (int i = 0; i < _moves.size(); i++) {
+        _scores[i] = _history ? _history->get(_position.sideToMove(), _moves[i]) : 0;
+    }
+}
+
+void MovePicker::scoreEvasions()
+{
+    for (int i = 0; i < _moves.size(); i++) {
+        const BitMove& move = _moves[i];
+        if (move.isCapture() || move.isPromotion()) {
+            _scores[i] = CaptureScore + captureScore(_position, move);
+        } else {
+            _scores[i] = _history ? _history->get(_position.sideToMove(), move) : 0;
+        }
+    }
+}
+
+bool MovePicker::alreadyPicked(const BitMove& move) const
+{
+    if (move == _ttMove) {
+        return true;
+    }
+    // the killers and the counter move only come out of the quiet stage's generation
+    return _stage == QUIET_MOVES && (move == _killers[0] || move == _killers[1] || move == _counterMove);
+}
+
+// the best remaining move of the current stage, skipping what went out already
+bool MovePicker::selectBest(BitMove& move)
+{
+    while (_index < _moves.size()) {
+        int best = _index;
+        for (int i = _index + 1; i < _moves.size(); i++) {
+            if (_scores[i] > _scores[best]) {
+                best = i;
+            }
+        }
+        std::swap(_moves[best], _moves[_index]);
+        std::swap(_scores[best], _scores[_index]);
+        move = _moves[_index++];
+        if (!alreadyPicked(move)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// a killer or counter move, if it's a quiet move that is legal here and hasn't come out yet
+bool MovePicker::pickSpecial(const BitMove& move, BitMove& picked)
+{
+    if (!move.isQuiet() || move == _ttMove || !isLegalMove(_position, move)) {
+        return false;
+    }
+    picked = move;
+    return true;
+}
+
+bool MovePicker::next(BitMove& move)
+{
+    while (true) {
+        switch (_stage) {
+        case TT_MOVE:
+            _stage = _type == EVASIONS ? GENERATE_EVASIONS : GENERATE_CAPTURES;
+            if (isLegalMove(_position, _ttMove)) {
+                move = _ttMove;
+                _picked++;
+                return true;
+            }
+            break;
+        case GENERATE_CAPTURES:
+            generateMoves(_position, CAPTURES, _moves);
+            scoreCaptures();
+            _index = 0;
+            _stage = CAPTURE_MOVES;
+            break;
+        case CAPTURE_MOVES:
+            while (selectBest(move)) {
+                // losing captures wait until the quiet moves have had their turn
+                if (!seeGE(_position, move, 0)) {
+                    _badCaptures.add(move);
+                    continue;
+                }
+                _picked++;
+                return true;
+            }
+            _stage = _type == CAPTURES ? BAD_CAPTURE_MOVES : KILLER_1;
+            break;
+        case KILLER_1:
+            _stage = KILLER_2;
+            if (pickSpecial(_killers[0], move)) {
+                _picked++;
+                return true;
+            }
+            break;
+        case KILLER_2:
+            _stage = COUNTER_MOVE;
+            if (_killers[1] != _killers[0] && pickSpecial(_killers[1], move)) {
+                _picked++;
+                return true;
+            }
+            break;
+        case COUNTER_MOVE:
+            _stage = GENERATE_QUIETS;
+            if (_counterMove != _killers[0] && _counterMove != _killers[1] && pickSpecial(_counterMove, move)) {
+                _picked++;
+                return true;
+            }
+            break;
+        case GENERATE_QUIETS:
+            generateMoves(_position, QUIETS, _moves);
+            scoreQuiets();
+            _index = 0;
+            _stage = QUIET_MOVES;
+            break;
+        case QUIET_MOVES:
+            if (selectBest(move)) {
+                _picked++;
+                return true;
+            }
+            _stage = BAD_CAPTURE_MOVES;
+            break;
+        case BAD_CAPTURE_MOVES:
+            if (_badIndex < _badCaptures.size()) {
+                move = _badCaptures[_badIndex++];
+                _picked++;
+                return true;
+            }
+            _stage = DONE;
+            break;
+        case EVASION_MOVES:
+            if (selectBest(move)) {
+                _picked++;
+                return true;
+            }
+            _stage = DONE;
+            break;
+        case GENERATE_EVASIONS:
+            generateMoves(_position, EVASIONS, _moves);
+            scoreEvasions();
+            _index = 0;
+            _stage = EVASION_MOVES;
+            break;
+        case DONE:
+            return false;
+        }
+    }
+}
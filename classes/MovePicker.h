@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Position.h"
+#include "MoveGenerator.h"
+
+// history scores are kept in [-MaxHistory, MaxHistory]
+constexpr int MaxHistory = 16384;
+
+//
+// butterfly history: how often a quiet move (side, from, to) caused a beta cutoff,
+// weighted by depth. bonuses shrink as a score approaches MaxHistory so the table
+// never overflows and old information slowly fades.
+//
+struct ButterflyHistory
+{
+    int table[2][64][64];
+
+    void clear();
+    int get(int side, const BitMove& move) const { return table[side == WHITE ? 0 : 1][move.from()][move.to()]; }
+    void update(int side, const BitMove& move, int bonus);
+};
+
+// two killer slots per ply: quiet moves that caused a cutoff at the same ply elsewhere
+struct KillerMoves
+{
+    BitMove moves[2];
+
+    void clear() { moves[0] = moves[1] = BitMove::none(); }
+    void add(const BitMove& move)
+    {
+        if (!(moves[0] == move)) {
+            moves[1] = moves[0];
+            moves[0] = move;
+        }
+    }
+};
+
+//
+// counter moves: the quiet move that last refuted a move, indexed by the piece
+// that made that move and where it went
+//
+struct CounterMoves
+{
+    BitMove table[12][64];
+
+    void clear();
+    BitMove get(int piece, int square) const { return table[piece][square]; }
+    void set(int piece, int square, const BitMove& move) { table[piece][square] = move; }
+};
+
+//
+// hands out moves best-first, generating them in stages: the TT move (nothing
+// generated yet), captures by MVV-LVA, the killers and the counter move (each
+// checked for legality on its own), the quiet moves by history, and last the
+// captures static exchange says lose material, held back from the capture stage.
+// a cutoff in an early stage means the later ones never get generated. in check
+// (EVASIONS) the evasions come out in one stage, and CAPTURES stops after the
+// captures, for quiescence. inside a stage next() selects the best remaining
+// move rather than sorting.
+//
+class MovePicker
+{
+public:
+    MovePicker(const Position& position, MoveGenType type, BitMove ttMove,
+               const KillerMoves* killers, const ButterflyHistory* history,
+               BitMove counterMove = BitMove::none());
+
+    bool next(BitMove& move);
+    // how many moves next() has handed out so far
+    int movesPicked() const { return _picked; }
+    // everything from here on is a capture that loses material
+    bool pickingBadCaptures() const { return _stage == BAD_CAPTURE_MOVES; }
+
+private:
+    enum Stage
+    {
+        TT_MOVE,
+        GENERATE_CAPTURES,
+        CAPTURE_MOVES,
+        KILLER_1,
+        KILLER_2,
+        COUNTER_MOVE,
+        GENERATE_QUIETS,
+        QUIET_MOVES,
+        BAD_CAPTURE_MOVES,
+        GENERATE_EVASIONS,
+        EVASION_MOVES,
+        DONE
+    };
+
+    void scoreCaptures();
+    void scoreQuiets();
+    void scoreEvasions();
+    bool selectBest(BitMove& move);
+    // a move an earlier stage already handed out
+    bool alreadyPicked(const BitMove& move) const;
+    bool pickSpecial(const BitMove& move, BitMove& picked);
+
+    const Position& _position;
+    MoveGenType _type;
+    Stage _stage;
+    BitMove _ttMove;
+    BitMove _killers[2];
+    BitMove _counterMove;
+    const ButterflyHistory* _history;
+    MoveList _moves;
+    MoveList _badCaptures;
+    int _scores[MAX_MOVES];
+    int _index;
+    int _badIndex;
+    int _picked;
+};
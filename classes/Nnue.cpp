@@ -0,0 +1,551 @@
+#include "Nnue.h"
+#include "MagicBitboards.h"
+#include "SliderFill.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || (defined(_MSC_VER) && defined(_M_X64))
+    #include <immintrin.h>
+    #define NNUE_HAVE_SIMD 1
+#endif
+
+// the SIMD kernels are compiled for their instruction set whatever the rest of
+// the build targets, and only ever run once the CPU has been checked
+#if defined(__GNUC__) || defined(__clang__)
+    #define NNUE_TARGET_AVX2 __attribute__((target("avx2")))
+    #define NNUE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+    #define NNUE_TARGET_AVX2
+    #define NNUE_TARGET_SSE41
+#endif
+
+NnueBackend NnueKernels = bestNnueBackend();
+
+// the most feature rows one accumulator update adds or removes: a few moves'
+// worth, or every piece but the kings for a refresh
+constexpr int MaxFeatureChanges = 32;
+// how many plies back an update will replay before it refreshes instead
+constexpr int MaxReplayPlies = 6;
+
+const char* nnueBackendName(NnueBackend backend)
+{
+    return backend == NNUE_AVX2 ? "avx2" : (backend == NNUE_SSE41 ? "sse4.1" : "scalar");
+}
+
+NnueBackend bestNnueBackend()
+{
+    if (cpuHasAvx2()) {
+        return NNUE_AVX2;
+    }
+#ifdef SLIDERS_HAVE_CPUID
+    unsigned regs[4];
+    cpuid(1, 0, regs);
+    if ((regs[2] >> 19) & 1) {
+        return NNUE_SSE41;
+    }
+#endif
+    return NNUE_SCALAR;
+}
+
+int nnueFeature(int perspective, int kingSquare, int piece, int square)
+{
+    int flip = perspective == WHITE ? 0 : 56;
+    int kind = (pieceTypeOf(piece) - Pawn) * 2 + (pieceColorOf(piece) == perspective ? 0 : 1);
+    return ((kingSquare ^ flip) * NnuePieceKinds + kind) * 64 + (square ^ flip);
+}
+
+NnueNetwork::Layout NnueNetwork::layout()
+{
+    Layout layout;
+    size_t offset = 0;
+    auto section = [&offset](size_t bytes) {
+        size_t start = offset;
+        offset = (offset + bytes + 63) & ~(size_t)63;
+        return start;
+    };
+    section(6 * sizeof(uint32_t)); // header
+    layout.featureBias = section(NnueAccumulatorSize * sizeof(int16_t));
+    layout.featureWeights = section((size_t)NnueInputs * NnueAccumulatorSize * sizeof(int16_t));
+    layout.hidden1Bias = section(NnueHiddenSize * sizeof(int32_t));
+    layout.hidden1Weights = section(NnueHiddenSize * 2 * NnueAccumulatorSize);
+    layout.hidden2Bias = section(NnueHiddenSize * sizeof(int32_t));
+    layout.hidden2Weights = section(NnueHiddenSize * NnueHiddenSize);
+    layout.outputBias = section(sizeof(int32_t));
+    layout.outputWeights = section(NnueHiddenSize);
+    layout.size = offset;
+    return layout;
+}
+
+bool NnueNetwork::load(const std::string& path)
+{
+    unload();
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = GetFileSizeEx(file, &fileSize) ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    if (mapping) {
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        size = (size_t)fileSize.QuadPart;
+    }
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+    _file = file;
+    _mapping = mapping;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        void* mapped = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped != MAP_FAILED) {
+            data = static_cast<const uint8_t*>(mapped);
+            size = (size_t)status.st_size;
+        }
+    }
+    // the mapping stays valid after the descriptor is gone
+    close(file);
+    if (!data) {
+        return false;
+    }
+#endif
+    _data = data;
+    _size = size;
+
+    Layout sections = layout();
+    uint32_t header[6];
+    if (size != sections.size) {
+        unload();
+        return false;
+    }
+    std::memcpy(header, data, sizeof(header));
+    if (std::memcmp(header, "NNUE", 4) != 0 || header[1] != Version || header[2] != (uint32_t)NnueInputs ||
+        header[3] != (uint32_t)NnueAccumulatorSize || header[4] != (uint32_t)NnueHiddenSize || (int32_t)header[5] <= 0) {
+        unload();
+        return false;
+    }
+    _outputScale = (int32_t)header[5];
+    _featureBias = reinterpret_cast<const int16_t*>(data + sections.featureBias);
+    _featureWeights = reinterpret_cast<const int16_t*>(data + sections.featureWeights);
+    _hidden1Bias = reinterpret_cast<const int32_t*>(data + sections.hidden1Bias);
+    _hidden1Weights = reinterpret_cast<const int8_t*>(data + sections.hidden1Weights);
+    _hidden2Bias = reinterpret_cast<const int32_t*>(data + sections.hidden2Bias);
+    _hidden2Weights = reinterpret_cast<const int8_t*>(data + sections.hidden2Weights);
+    _outputBias = reinterpret_cast<const int32_t*>(data + sections.outputBias);
+    _outputWeights = reinterpret_cast<const int8_t*>(data + sections.outputWeights);
+    return true;
+}
+
+void NnueNetwork::unload()
+{
+    if (!_data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle((HANDLE)_mapping);
+    CloseHandle((HANDLE)_file);
+    _file = _mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+//
+// kernels. accumulator updates: out = in + the added rows - the removed rows.
+// forward passes: accumulators in, the output layer's sum (before the scale) out
+//
+
+struct NnueLayers
+{
+    const int32_t* hidden1Bias;
+    const int8_t* hidden1Weights;
+    const int32_t* hidden2Bias;
+    const int8_t* hidden2Weights;
+    int32_t outputBias;
+    const int8_t* outputWeights;
+};
+
+static inline uint8_t clipHidden(int32_t sum)
+{
+    return (uint8_t)std::clamp(sum >> NnueWeightShift, 0, 127);
+}
+
+static void updateScalar(int16_t* out, const int16_t* in, const int16_t* const* added, int addCount,
+                         const int16_t* const* removed, int removeCount)
+{
+    for (int i = 0; i < NnueAccumulatorSize; i++) {
+        int value = in[i];
+        for (int row = 0; row < addCount; row++) {
+            value += added[row][i];
+        }
+        for (int row = 0; row < removeCount; row++) {
+            value -= removed[row][i];
+        }
+        out[i] = (int16_t)value;
+    }
+}
+
+static int32_t forwardScalar(const NnueLayers& layers, const int16_t* us, const int16_t* them)
+{
+    uint8_t input[2 * NnueAccumulatorSize];
+    for (int i = 0; i < NnueAccumulatorSize; i++) {
+        input[i] = (uint8_t)std::clamp((int)us[i], 0, 127);
+        input[NnueAccumulatorSize + i] = (uint8_t)std::clamp((int)them[i], 0, 127);
+    }
+    uint8_t hidden1[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        const int8_t* weights = layers.hidden1Weights + out * 2 * NnueAccumulatorSize;
+        int32_t sum = layers.hidden1Bias[out];
+        for (int i = 0; i < 2 * NnueAccumulatorSize; i++) {
+            sum += input[i] * weights[i];
+        }
+        hidden1[out] = clipHidden(sum);
+    }
+    uint8_t hidden2[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        const int8_t* weights = layers.hidden2Weights + out * NnueHiddenSize;
+        int32_t sum = layers.hidden2Bias[out];
+        for (int i = 0; i < NnueHiddenSize; i++) {
+            sum += hidden1[i] * weights[i];
+        }
+        hidden2[out] = clipHidden(sum);
+    }
+    int32_t output = layers.outputBias;
+    for (int i = 0; i < NnueHiddenSize; i++) {
+        output += hidden2[i] * layers.outputWeights[i];
+    }
+    return output;
+}
+
+#ifdef NNUE_HAVE_SIMD
+NNUE_TARGET_SSE41 static void updateSse41(int16_t* out, const int16_t* in, const int16_t* const* added, int addCount,
+                                          const int16_t* const* removed, int removeCount)
+{
+    // 64 values at a time, kept in registers across all the rows
+    constexpr int Registers = 8;
+    for (int block = 0; block < NnueAccumulatorSize; block += Registers * 8) {
+        __m128i sums[Registers];
+        for (int r = 0; r < Registers; r++) {
+            sums[r] = _mm_loadu_si128((const __m128i*)(in + block + r * 8));
+        }
+        for (int row = 0; row < addCount; row++) {
+            for (int r = 0; r < Registers; r++) {
+                sums[r] = _mm_add_epi16(sums[r], _mm_loadu_si128((const __m128i*)(added[row] + block + r * 8)));
+            }
+        }
+        for (int row = 0; row < removeCount; row++) {
+            for (int r = 0; r < Registers; r++) {
+                sums[r] = _mm_sub_epi16(sums[r], _mm_loadu_si128((const __m128i*)(removed[row] + block + r * 8)));
+            }
+        }
+        for (int r = 0; r < Registers; r++) {
+            _mm_storeu_si128((__m128i*)(out + block + r * 8), sums[r]);
+        }
+    }
+}
+
+// sum of inputs * weights over size bytes (a multiple of 16). the pairwise
+// uint8 * int8 products can't saturate int16 with inputs capped at 127
+NNUE_TARGET_SSE41 static inline int32_t dotSse41(const uint8_t* input, const int8_t* weights, int size)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i sum = _mm_setzero_si128();
+    for (int i = 0; i < size; i += 16) {
+        __m128i products = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(input + i)),
+                                             _mm_loadu_si128((const __m128i*)(weights + i)));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+NNUE_TARGET_SSE41 static void clipAccumulatorSse41(uint8_t* output, const int16_t* values)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int i = 0; i < NnueAccumulatorSize; i += 16) {
+        __m128i packed = _mm_packs_epi16(_mm_loadu_si128((const __m128i*)(values + i)),
+                                         _mm_loadu_si128((const __m128i*)(values + i + 8)));
+        _mm_storeu_si128((__m128i*)(output + i), _mm_max_epi8(packed, zero));
+    }
+}
+
+NNUE_TARGET_SSE41 static int32_t forwardSse41(const NnueLayers& layers, const int16_t* us, const int16_t* them)
+{
+    alignas(64) uint8_t input[2 * NnueAccumulatorSize];
+    clipAccumulatorSse41(input, us);
+    clipAccumulatorSse41(input + NnueAccumulatorSize, them);
+    alignas(64) uint8_t hidden1[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        hidden1[out] = clipHidden(layers.hidden1Bias[out]
+            + dotSse41(input, layers.hidden1Weights + out * 2 * NnueAccumulatorSize, 2 * NnueAccumulatorSize));
+    }
+    alignas(64) uint8_t hidden2[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        hidden2[out] = clipHidden(layers.hidden2Bias[out] + dotSse41(hidden1, layers.hidden2Weights + out * NnueHiddenSize, NnueHiddenSize));
+    }
+    return layers.outputBias + dotSse41(hidden2, layers.outputWeights, NnueHiddenSize);
+}
+
+NNUE_TARGET_AVX2 static void updateAvx2(int16_t* out, const int16_t* in, const int16_t* const* added, int addCount,
+                                        const int16_t* const* removed, int removeCount)
+{
+    // 128 values at a time, kept in registers across all the rows
+    constexpr int Registers = 8;
+    for (int block = 0; block < NnueAccumulatorSize; block += Registers * 16) {
+        __m256i sums[Registers];
+        for (int r = 0; r < Registers; r++) {
+            sums[r] = _mm256_loadu_si256((const __m256i*)(in + block + r * 16));
+        }
+        for (int row = 0; row < addCount; row++) {
+            for (int r = 0; r < Registers; r++) {
+                sums[r] = _mm256_add_epi16(sums[r], _mm256_loadu_si256((const __m256i*)(added[row] + block + r * 16)));
+            }
+        }
+        for (int row = 0; row < removeCount; row++) {
+            for (int r = 0; r < Registers; r++) {
+                sums[r] = _mm256_sub_epi16(sums[r], _mm256_loadu_si256((const __m256i*)(removed[row] + block + r * 16)));
+            }
+        }
+        for (int r = 0; r < Registers; r++) {
+            _mm256_storeu_si256((__m256i*)(out + block + r * 16), sums[r]);
+        }
+    }
+}
+
+NNUE_TARGET_AVX2 static inline int32_t dotAvx2(const uint8_t* input, const int8_t* weights, int size)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32) {
+        __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(input + i)),
+                                                _mm256_loadu_si256((const __m256i*)(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+    return _mm_cvtsi128_si32(half);
+}
+
+NNUE_TARGET_AVX2 static void clipAccumulatorAvx2(uint8_t* output, const int16_t* values)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < NnueAccumulatorSize; i += 32) {
+        __m256i packed = _mm256_packs_epi16(_mm256_loadu_si256((const __m256i*)(values + i)),
+                                            _mm256_loadu_si256((const __m256i*)(values + i + 16)));
+        // packs works within 128 bit lanes, put the quarters back in order
+        packed = _mm256_permute4x64_epi64(packed, 0xd8);
+        _mm256_storeu_si256((__m256i*)(output + i), _mm256_max_epi8(packed, zero));
+    }
+}
+
+NNUE_TARGET_AVX2 static int32_t forwardAvx2(const NnueLayers& layers, const int16_t* us, const int16_t* them)
+{
+    alignas(64) uint8_t input[2 * NnueAccumulatorSize];
+    clipAccumulatorAvx2(input, us);
+    clipAccumulatorAvx2(input + NnueAccumulatorSize, them);
+    alignas(64) uint8_t hidden1[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        hidden1[out] = clipHidden(layers.hidden1Bias[out]
+            + dotAvx2(input, layers.hidden1Weights + out * 2 * NnueAccumulatorSize, 2 * NnueAccumulatorSize));
+    }
+    alignas(64) uint8_t hidden2[NnueHiddenSize];
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        hidden2[out] = clipHidden(layers.hidden2Bias[out] + dotAvx2(hidden1, layers.hidden2Weights + out * NnueHiddenSize, NnueHiddenSize));
+    }
+    return layers.outputBias + dotAvx2(hidden2, layers.outputWeights, NnueHiddenSize);
+}
+#endif
+
+static void updateAccumulator(int16_t* out, const int16_t* in, const int16_t* const* added, int addCount,
+                              const int16_t* const* removed, int removeCount)
+{
+#ifdef NNUE_HAVE_SIMD
+    if (NnueKernels == NNUE_AVX2) {
+        updateAvx2(out, in, added, addCount, removed, removeCount);
+        return;
+    }
+    if (NnueKernels == NNUE_SSE41) {
+        updateSse41(out, in, added, addCount, removed, removeCount);
+        return;
+    }
+#endif
+    updateScalar(out, in, added, addCount, removed, removeCount);
+}
+
+int NnueNetwork::evaluate(const NnueAccumulator& accumulator, int sideToMove) const
+{
+    NnueLayers layers = { _hidden1Bias, _hidden1Weights, _hidden2Bias, _hidden2Weights, *_outputBias, _outputWeights };
+    const int16_t* us = accumulator.values[sideToMove == WHITE ? 0 : 1];
+    const int16_t* them = accumulator.values[sideToMove == WHITE ? 1 : 0];
+    int32_t output;
+#ifdef NNUE_HAVE_SIMD
+    if (NnueKernels == NNUE_AVX2) {
+        output = forwardAvx2(layers, us, them);
+    } else if (NnueKernels == NNUE_SSE41) {
+        output = forwardSse41(layers, us, them);
+    } else
+#endif
+    {
+        output = forwardScalar(layers, us, them);
+    }
+    return output / _outputScale;
+}
+
+//
+// accumulator stack
+//
+
+NnueStack::NnueStack()
+{
+    for (NnueAccumulator& accumulator : _stack) {
+        accumulator.key = 0;
+    }
+}
+
+// one side's accumulator from nothing: the bias plus a row per piece but the kings.
+// a side set up without a king has no inputs at all, just the bias
+static void refreshSide(const Position& position, int perspective, int16_t* values)
+{
+    const int16_t* rows[MaxFeatureChanges];
+    int count = 0;
+    int kingSquare = position.kingSquare(perspective);
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING && kingSquare != NO_SQUARE; piece++) {
+        if (pieceTypeOf(piece) == King) {
+            continue;
+        }
+        for (uint64_t pieces = position.pieces(piece); pieces && count < MaxFeatureChanges; pieces &= pieces - 1) {
+            rows[count++] = Network.featureWeights(nnueFeature(perspective, kingSquare, piece, getFirstBit(pieces)));
+        }
+    }
+    updateAccumulator(values, Network.featureBias(), rows, count, nullptr, 0);
+}
+
+void NnueStack::refresh(const Position& position, NnueAccumulator& accumulator)
+{
+    refreshSide(position, WHITE, accumulator.values[0]);
+    refreshSide(position, BLACK, accumulator.values[1]);
+    accumulator.key = position.key();
+}
+
+// the pieces one move put down and picked up
+struct PieceChanges
+{
+    int count = 0;
+    int pieces[3];
+    int squares[3];
+
+    void add(int piece, int square)
+    {
+        pieces[count] = piece;
+        squares[count++] = square;
+    }
+};
+
+static void moveChanges(const UndoInfo& undo, PieceChanges& added, PieceChanges& removed)
+{
+    const BitMove& move = undo.move;
+    if (move.isNone()) {
+        return;
+    }
+    int side = pieceColorOf(undo.movedPiece);
+    removed.add(undo.movedPiece, move.from());
+    added.add(move.isPromotion() ? pieceIndexFor(move.promotionPiece(), side) : undo.movedPiece, move.to());
+    if (undo.capturedPiece != EMPTY_SQUARES) {
+        removed.add(undo.capturedPiece, move.isEnPassant() ? move.to() - 8 * side : move.to());
+    }
+    if (move.isCastle()) {
+        int rook = pieceIndexFor(Rook, side);
+        removed.add(rook, move.flags() == KING_CASTLE ? move.to() + 1 : move.to() - 2);
+        added.add(rook, move.flags() == KING_CASTLE ? move.to() - 1 : move.to() + 1);
+    }
+}
+
+const NnueAccumulator& NnueStack::accumulatorFor(const Position& position)
+{
+    int ply = position.ply();
+    NnueAccumulator& target = _stack[ply];
+    if (target.key == position.key()) {
+        return target;
+    }
+
+    // the nearest ancestor whose accumulators are still in the stack
+    int base = ply - 1;
+    while (base >= 0 && ply - base <= MaxReplayPlies && _stack[base].key != position.undoInfo(base).key) {
+        base--;
+    }
+    if (base < 0 || ply - base > MaxReplayPlies) {
+        refresh(position, target);
+        return target;
+    }
+
+    for (int color = 0; color < 2; color++) {
+        int perspective = color == 0 ? WHITE : BLACK;
+        int king = pieceIndexFor(King, perspective);
+        int kingSquare = position.kingSquare(perspective);
+        const int16_t* addedRows[MaxFeatureChanges];
+        const int16_t* removedRows[MaxFeatureChanges];
+        int addCount = 0;
+        int removeCount = 0;
+        // without a king there are no rows to look up, the refresh gives the bias
+        bool kingMoved = kingSquare == NO_SQUARE;
+        for (int i = base; i < ply && !kingMoved; i++) {
+            const UndoInfo& undo = position.undoInfo(i);
+            kingMoved = undo.movedPiece == king;
+            PieceChanges added;
+            PieceChanges removed;
+            moveChanges(undo, added, removed);
+            for (int j = 0; j < added.count; j++) {
+                if (pieceTypeOf(added.pieces[j]) != King) {
+                    addedRows[addCount++] = Network.featureWeights(nnueFeature(perspective, kingSquare, added.pieces[j], added.squares[j]));
+                }
+            }
+            for (int j = 0; j < removed.count; j++) {
+                if (pieceTypeOf(removed.pieces[j]) != King) {
+                    removedRows[removeCount++] = Network.featureWeights(nnueFeature(perspective, kingSquare, removed.pieces[j], removed.squares[j]));
+                }
+            }
+        }
+        // every input of this side's view depends on where its king is
+        if (kingMoved) {
+            refreshSide(position, perspective, target.values[color]);
+        } else {
+            updateAccumulator(target.values[color], _stack[base].values[color], addedRows, addCount, removedRows, removeCount);
+        }
+    }
+    target.key = position.key();
+    return target;
+}
+
+int NnueStack::evaluate(const Position& position)
+{
+    return Network.evaluate(accumulatorFor(position), position.sideToMove());
+}
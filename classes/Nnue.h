@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Position.h"
+
+//
+// efficiently updatable neural network evaluation (NNUE), HalfKP inputs:
+// for each side, every non-king piece seen from that side's king, as
+// (king square, piece kind, square) with black's view flipped so both sides
+// look up the board. 64 * 10 * 64 inputs feed a 256 wide int16 accumulator per
+// side; a move only touches a few inputs, so accumulators are updated by adding
+// and subtracting weight rows rather than recomputed. after that it's a small
+// quantized network: both accumulators (side to move first) clipped to [0, 127]
+// as uint8, 512 -> 32 -> 32 -> 1 with int8 weights and int32 sums.
+//
+constexpr int NnueKingSquares = 64;
+constexpr int NnuePieceKinds = 10; // pawn to queen, own then enemy for each
+constexpr int NnueInputs = NnueKingSquares * NnuePieceKinds * 64;
+constexpr int NnueAccumulatorSize = 256;
+constexpr int NnueHiddenSize = 32;
+// hidden layer sums are scaled down by this many bits before clipping
+constexpr int NnueWeightShift = 6;
+
+// accumulators plus which position they are for (its Zobrist key)
+struct alignas(64) NnueAccumulator
+{
+    int16_t values[2][NnueAccumulatorSize]; // white's view, then black's
+    uint64_t key;
+};
+
+enum NnueBackend { NNUE_SCALAR, NNUE_SSE41, NNUE_AVX2 };
+
+//
+// a network file mapped into memory read-only, the weights used in place.
+// layout (little endian), every section starting on a 64 byte boundary:
+//   header: "NNUE", uint32 version, uint32 inputs, uint32 accumulator size,
+//           uint32 hidden size, int32 output scale
+//   int16 feature bias[256], int16 feature weights[inputs][256]
+//   int32 bias[32], int8 weights[32][512]     (first hidden layer, by output)
+//   int32 bias[32], int8 weights[32][32]      (second hidden layer)
+//   int32 bias, int8 weights[32]              (output, divided by the scale)
+//
+class NnueNetwork
+{
+public:
+    NnueNetwork() = default;
+    ~NnueNetwork() { unload(); }
+    NnueNetwork(const NnueNetwork&) = delete;
+    NnueNetwork& operator=(const NnueNetwork&) = delete;
+
+    // maps path, false (and nothing loaded) if it can't be read or isn't a network
+    bool load(const std::string& path);
+    void unload();
+    bool loaded() const { return _data != nullptr; }
+
+    static constexpr uint32_t Version = 1;
+
+    // where each section starts in the file, and the file's size
+    struct Layout
+    {
+        size_t featureBias, featureWeights;
+        size_t hidden1Bias, hidden1Weights;
+        size_t hidden2Bias, hidden2Weights;
+        size_t outputBias, outputWeights;
+        size_t size;
+    };
+    static Layout layout();
+
+    const int16_t* featureBias() const { return _featureBias; }
+    const int16_t* featureWeights(int feature) const { return _featureWeights + (size_t)feature * NnueAccumulatorSize; }
+    // centipawns for the side to move, from a pair of accumulators
+    int evaluate(const NnueAccumulator& accumulator, int sideToMove) const;
+
+private:
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+    const int16_t* _featureBias = nullptr;
+    const int16_t* _featureWeights = nullptr;
+    const int32_t* _hidden1Bias = nullptr;
+    const int8_t* _hidden1Weights = nullptr;
+    const int32_t* _hidden2Bias = nullptr;
+    const int8_t* _hidden2Weights = nullptr;
+    const int32_t* _outputBias = nullptr;
+    const int8_t* _outputWeights = nullptr;
+    int _outputScale = 1;
+};
+
+// the process wide network, nothing loaded until loadNetwork succeeds
+inline NnueNetwork Network;
+// kernels picked at startup from what the CPU has, a tool may override it
+extern NnueBackend NnueKernels;
+
+const char* nnueBackendName(NnueBackend backend);
+NnueBackend bestNnueBackend();
+
+inline bool loadNetwork(const std::string& path) { return Network.load(path); }
+inline bool networkLoaded() { return Network.loaded(); }
+
+// input index of piece (WHITE_PAWNS..BLACK_QUEEN) on square, as perspective
+// (WHITE or BLACK) with its king on kingSquare sees it
+int nnueFeature(int perspective, int kingSquare, int piece, int square);
+
+//
+// one accumulator per ply, owned by whoever evaluates (a search thread). entries
+// are filled lazily when a position is evaluated: from the nearest ancestor still
+// in the stack by replaying the moves in between (the position's undo records),
+// or from scratch for a side whose king moved. unmaking a move costs nothing, the
+// parent's entry is still there
+//
+class NnueStack
+{
+public:
+    NnueStack();
+
+    // centipawns for the side to move
+    int evaluate(const Position& position);
+    // the accumulators for position, brought up to date
+    const NnueAccumulator& accumulatorFor(const Position& position);
+    // recomputes both sides from scratch, for checking the incremental updates
+    static void refresh(const Position& position, NnueAccumulator& accumulator);
+
+private:
+    NnueAccumulator _stack[MAX_PLY + 1];
+};
@@ -0,0 +1,26 @@
+#include "PawnTable.h"
+
+PawnTable::PawnTable(size_t entries)
+    : _entries(entries), _probes(0), _hits(0)
+{
+    clear();
+}
+
+// an empty slot reads as the evaluation of no pawns at all (key 0), which is
+// what it is, so it never needs telling apart from a filled one
+void PawnTable::clear()
+{
+    for (PawnEntry& entry : _entries) {
+        reset(entry, 0);
+    }
+    resetStats();
+}
+
+void PawnTable::reset(PawnEntry& entry, uint64_t key)
+{
+    entry.key = key;
+    entry.structure = 0;
+    entry.passed[0] = entry.passed[1] = 0;
+    entry.kingSquare[0] = entry.kingSquare[1] = NoKingSquare;
+    entry.shelter[0] = entry.shelter[1] = 0;
+}
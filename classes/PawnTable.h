@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// one cached pawn evaluation, from white's point of view
+struct PawnEntry
+{
+    uint64_t key;
+    int structure;           // packed middlegame/endgame Score of the pawn terms
+    uint64_t passed[2];      // passed pawns, white then black
+    uint8_t kingSquare[2];   // where each king stood when its shelter was scored
+    int16_t shelter[2];      // middlegame only, positive is good for that side
+};
+
+//
+// per thread cache of pawn evaluations keyed by the position's pawn-only Zobrist
+// key. pawns move rarely, so nearly every probe in a search hits. an entry is
+// always handed back; when it's for other pawns it has been reset for the caller
+// to fill. the king shelter inside is redone only when that king has moved
+//
+class PawnTable
+{
+public:
+    explicit PawnTable(size_t entries = DefaultEntries);
+
+    void clear();
+    // the entry for key, and whether it already held key's evaluation
+    PawnEntry& probe(uint64_t key, bool& hit)
+    {
+        PawnEntry& entry = _entries[key & (_entries.size() - 1)];
+        _probes++;
+        hit = entry.key == key;
+        if (hit) {
+            _hits++;
+        } else {
+            reset(entry, key);
+        }
+        return entry;
+    }
+
+    uint64_t probes() const { return _probes; }
+    uint64_t hits() const { return _hits; }
+    void resetStats() { _probes = _hits = 0; }
+
+    // marks a shelter that hasn't been scored yet
+    static constexpr uint8_t NoKingSquare = 64;
+
+private:
+    static constexpr size_t DefaultEntries = 1 << 14;
+    static void reset(PawnEntry& entry, uint64_t key);
+
+    std::vector<PawnEntry> _entries;
+    uint64_t _probes;
+    uint64_t _hits;
+};
@@ -4,19 +4,26 @@
 #include <cstdint>
 
 // Define piece values for material evaluation
-const int PAWN_VALUE = 100;
-const int KNIGHT_VALUE = 320;
-const int BISHOP_VALUE = 330;
-const int ROOK_VALUE = 500;
-const int QUEEN_VALUE = 900;
-const int KING_VALUE = 20000; // King value is often arbitrary as it can't be captured for material gain
+constexpr int PAWN_VALUE = 100;
+constexpr int KNIGHT_VALUE = 320;
+constexpr int BISHOP_VALUE = 330;
+constexpr int ROOK_VALUE = 500;
+constexpr int QUEEN_VALUE = 900;
+constexpr int KING_VALUE = 20000; // King value is often arbitrary as it can't be captured for material gain
+
+// Endgame piece values: pawns and rooks gain as the board empties, minor pieces lose a little
+constexpr int PAWN_VALUE_END = 130;
+constexpr int KNIGHT_VALUE_END = 290;
+constexpr int BISHOP_VALUE_END = 320;
+constexpr int ROOK_VALUE_END = 540;
+constexpr int QUEEN_VALUE_END = 950;
 
 // Piece-Square Tables (PSTs) for Middle Game
 // The values are defined for White pieces on their side of the board.
 // Black's tables are mirrored.
 // Represented as a 8x8 array (or a 1D array of 64 elements for convenience)
 
-const int PawnTableMid[64] = {
+constexpr int PawnTableMid[64] = {
      0,  0,  0,  0,  0,  0,  0,  0,
     50, 50, 50, 50, 50, 50, 50, 50,
     10, 10, 20, 30, 30, 20, 10, 10,
@@ -27,7 +34,7 @@ const int PawnTableMid[64] = {
      0,  0,  0,  0,  0,  0,  0,  0
 };
 
-const int KnightTableMid[64] = {
+constexpr int KnightTableMid[64] = {
    -50,-40,-30,-30,-30,-30,-40,-50,
    -40,-20,  0,  0,  0,  0,-20,-40,
    -30,  0, 10, 15, 15, 10,  0,-30,
@@ -38,7 +45,7 @@ const int KnightTableMid[64] = {
    -50,-40,-30,-30,-30,-30,-40,-50
 };
 
-const int rookTable[64] = {
+constexpr int rookTable[64] = {
     0, 0, 0, 5, 5, 0, 0, 0,
     -5, 0, 0, 0, 0, 0, 0, -5,
     -5, 0, 0, 0, 0, 0, 0, -5,
@@ -48,7 +55,7 @@ const int rookTable[64] = {
     5, 10, 10, 10, 10, 10, 10, 5,
     0, 0, 0, 0, 0, 0, 0, 0
 };
-const int queenTable[64] = {
+constexpr int queenTable[64] = {
     -20, -10, -10, -5, -5, -10, -10, -20,
     -10, 0, 0, 0, 0, 0, 0, -10,
     -10, 0, 5, 5, 5, 5, 0, -10,
@@ -59,7 +66,7 @@ const int queenTable[64] = {
     -20, -10, -10, -5, -5, -10, -10, -20
 };
 
-const int bishopTable[64] = {
+constexpr int bishopTable[64] = {
     -20, -10, -10, -10, -10, -10, -10, -20,
     -10, 0, 0, 0, 0, 0, 0, -10,
     -10, 0, 5, 10, 10, 5, 0, -10,
@@ -70,7 +77,7 @@ const int bishopTable[64] = {
     -20, -10, -10, -10, -10, -10, -10, -20
 };
 
-const int kingTable[64] = {
+constexpr int kingTable[64] = {
     20, 30, 10, 0, 0, 10, 30, 20,
     20, 20, 0, 0, 0, 0, 20, 20,
     -10, -20, -20, -20, -20, -20, -20, -10,
@@ -80,4 +87,73 @@ const int kingTable[64] = {
     -30, -40, -40, -50, -50, -40, -40, -30,
     -30, -40, -40, -50, -50, -40, -40, -30
 };
+
+// Piece-Square Tables (PSTs) for the End Game, same layout as the middle game ones.
+// Passed pawns and a central king matter most once the heavy pieces are gone
+
+constexpr int PawnTableEnd[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    80, 80, 80, 80, 80, 80, 80, 80,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    30, 30, 30, 30, 30, 30, 30, 30,
+    20, 20, 20, 20, 20, 20, 20, 20,
+    10, 10, 10, 10, 10, 10, 10, 10,
+    10, 10, 10, 10, 10, 10, 10, 10,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+constexpr int KnightTableEnd[64] = {
+   -40,-30,-20,-20,-20,-20,-30,-40,
+   -30,-15,  0,  0,  0,  0,-15,-30,
+   -20,  0, 10, 15, 15, 10,  0,-20,
+   -20,  5, 15, 20, 20, 15,  5,-20,
+   -20,  5, 15, 20, 20, 15,  5,-20,
+   -20,  0, 10, 15, 15, 10,  0,-20,
+   -30,-15,  0,  0,  0,  0,-15,-30,
+   -40,-30,-20,-20,-20,-20,-30,-40
+};
+
+constexpr int bishopTableEnd[64] = {
+    -15, -10, -10, -10, -10, -10, -10, -15,
+    -10, 0, 0, 0, 0, 0, 0, -10,
+    -10, 0, 5, 5, 5, 5, 0, -10,
+    -10, 0, 5, 10, 10, 5, 0, -10,
+    -10, 0, 5, 10, 10, 5, 0, -10,
+    -10, 0, 5, 5, 5, 5, 0, -10,
+    -10, 0, 0, 0, 0, 0, 0, -10,
+    -15, -10, -10, -10, -10, -10, -10, -15
+};
+
+constexpr int rookTableEnd[64] = {
+    0, 0, 0, 0, 0, 0, 0, 0,
+    10, 10, 10, 10, 10, 10, 10, 10,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0
+};
+
+constexpr int queenTableEnd[64] = {
+    -20, -10, -10, -5, -5, -10, -10, -20,
+    -10, 0, 5, 5, 5, 5, 0, -10,
+    -10, 5, 10, 10, 10, 10, 5, -10,
+    -5, 5, 10, 15, 15, 10, 5, -5,
+    -5, 5, 10, 15, 15, 10, 5, -5,
+    -10, 5, 10, 10, 10, 10, 5, -10,
+    -10, 0, 5, 5, 5, 5, 0, -10,
+    -20, -10, -10, -5, -5, -10, -10, -20
+};
+
+constexpr int kingTableEnd[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10, 0, 0, -10, -20, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 30, 40, 40, 30, -10, -30,
+    -30, -10, 20, 30, 30, 20, -10, -30,
+    -30, -30, 0, 0, 0, 0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50
+};
 #endif // PIECESQUARE_H
\ No newline at end of file
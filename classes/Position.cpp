@@ -0,0 +1,389 @@
+#include "Position.h"
+#include "Zobrist.h"
+#include "Evaluate.h"
+#include "MagicBitboards.h"
+#include <cctype>
+
+static const char* pieceChars = "PNBRQKpnbrqk";
+
+// castling rights that survive a move touching each square (king and rook home squares clear theirs)
+static const struct CastlingMaskTable
+{
+    uint8_t mask[64];
+
+    CastlingMaskTable()
+    {
+        for (int square = 0; square < 64; square++) {
+            mask[square] = ALL_CASTLING;
+        }
+        mask[4] &= ~(WHITE_OO | WHITE_OOO);
+        mask[7] &= ~WHITE_OO;
+        mask[0] &= ~WHITE_OOO;
+        mask[60] &= ~(BLACK_OO | BLACK_OOO);
+        mask[63] &= ~BLACK_OO;
+        mask[56] &= ~BLACK_OOO;
+    }
+} CastlingMasks;
+
+std::string moveToString(const BitMove& move)
+{
+    std::string s;
+    s += (char)('a' + (move.from() & 7));
+    s += (char)('1' + (move.from() >> 3));
+    s += (char)('a' + (move.to() & 7));
+    s += (char)('1' + (move.to() >> 3));
+    if (move.isPromotion()) {
+        s += "nbrq"[move.promotionPiece() - Knight];
+    }
+    return s;
+}
+
+Position::Position()
+{
+    clear();
+}
+
+void Position::clear()
+{
+    for (int i = 0; i < eNUM_BITBOARDS; i++) {
+        _bitboards[i] = 0;
+    }
+    _bitboards[EMPTY_SQUARES] = ~0ULL;
+    for (int i = 0; i < 64; i++) {
+        _mailbox[i] = EMPTY_SQUARES;
+    }
+    _sideToMove = WHITE;
+    _castlingRights = 0;
+    _epSquare = NO_SQUARE;
+    _ply = 0;
+    _key = 0;
+    _pawnKey = 0;
+    _psqt = 0;
+    _phase = 0;
+}
+
+void Position::setFromStateString(const std::string& state, int sideToMove)
+{
+    clear();
+    for (int square = 0; square < 64 && square < (int)state.size(); square++) {
+        for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+            if (state[square] == pieceChars[piece]) {
+                addPiece(piece, square);
+                break;
+            }
+        }
+    }
+    _sideToMove = sideToMove;
+    if (_mailbox[4] == WHITE_KING) {
+        _castlingRights |= (_mailbox[7] == WHITE_ROOKS ? WHITE_OO : 0) | (_mailbox[0] == WHITE_ROOKS ? WHITE_OOO : 0);
+    }
+    if (_mailbox[60] == BLACK_KING) {
+        _castlingRights |= (_mailbox[63] == BLACK_ROOKS ? BLACK_OO : 0) | (_mailbox[56] == BLACK_ROOKS ? BLACK_OOO : 0);
+    }
+    _key = computeKey();
+}
+
+uint64_t Position::computeKey() const
+{
+    uint64_t key = 0;
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+        _bitboards[piece].forEachBit([&](int square) {
+            key ^= Zobrist.pieceSquare[piece][square];
+        });
+    }
+    if (_sideToMove == BLACK) {
+        key ^= Zobrist.blackToMove;
+    }
+    key ^= Zobrist.castling[_castlingRights];
+    if (_epSquare != NO_SQUARE) {
+        key ^= Zobrist.enPassantFile[_epSquare & 7];
+    }
+    return key;
+}
+
+uint64_t Position::computePawnKey() const
+{
+    uint64_t key = 0;
+    for (int piece : { WHITE_PAWNS, BLACK_PAWNS }) {
+        _bitboards[piece].forEachBit([&](int square) {
+            key ^= Zobrist.pieceSquare[piece][square];
+        });
+    }
+    return key;
+}
+
+int Position::computePsqt() const
+{
+    int score = 0;
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+        _bitboards[piece].forEachBit([&](int square) {
+            score += Psqt.score[piece][square];
+        });
+    }
+    return score;
+}
+
+int Position::computePhase() const
+{
+    int phase = 0;
+    for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+        phase += PhaseWeights[pieceTypeOf(piece)] * countOnes(_bitboards[piece].getData());
+    }
+    return phase;
+}
+
+void Position::setFromFEN(const std::string& fen)
+{
+    clear();
+    int rank = 7;
+    int file = 0;
+    size_t i = 0;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        char ch = fen[i];
+        if (ch == '/') {
+            rank--;
+            file = 0;
+        } else if (isdigit(ch)) {
+            file += ch - '0';
+        } else {
+            for (int piece = WHITE_PAWNS; piece <= BLACK_KING; piece++) {
+                if (ch == pieceChars[piece] && rank >= 0 && file < 8) {
+                    addPiece(piece, rank * 8 + file);
+                    break;
+                }
+            }
+            file++;
+        }
+    }
+    _sideToMove = (i + 1 < fen.size() && fen[i + 1] == 'b') ? BLACK : WHITE;
+
+    // castling field, then the en passant square
+    i += 3;
+    for (; i < fen.size() && fen[i] != ' '; i++) {
+        switch (fen[i]) {
+            case 'K': _castlingRights |= WHITE_OO; break;
+            case 'Q': _castlingRights |= WHITE_OOO; break;
+            case 'k': _castlingRights |= BLACK_OO; break;
+            case 'q': _castlingRights |= BLACK_OOO; break;
+        }
+    }
+    i++;
+    if (i + 1 < fen.size() && fen[i] >= 'a' && fen[i] <= 'h' && isdigit(fen[i + 1])) {
+        setEnPassant((fen[i + 1] - '1') * 8 + (fen[i] - 'a'));
+    }
+    _key = computeKey();
+}
+
+std::string Position::stateString() const
+{
+    std::string s(64, '0');
+    for (int square = 0; square < 64; square++) {
+        if (_mailbox[square] != EMPTY_SQUARES) {
+            s[square] = pieceChars[_mailbox[square]];
+        }
+    }
+    return s;
+}
+
+uint64_t Position::attackersTo(int square, uint64_t occupancy) const
+{
+    uint64_t squareBit = 1ULL << square;
+    uint64_t rooksQueens = pieces(WHITE_ROOKS) | pieces(WHITE_QUEENS) | pieces(BLACK_ROOKS) | pieces(BLACK_QUEENS);
+    uint64_t bishopsQueens = pieces(WHITE_BISHOPS) | pieces(WHITE_QUEENS) | pieces(BLACK_BISHOPS) | pieces(BLACK_QUEENS);
+    // a white pawn attacks square if a black pawn on square would attack the pawn, and vice versa
+    return (BLACK_PAWN_ATTACKS(squareBit) & pieces(WHITE_PAWNS))
+         | (WHITE_PAWN_ATTACKS(squareBit) & pieces(BLACK_PAWNS))
+         | (KnightAttacks[square] & (pieces(WHITE_KNIGHTS) | pieces(BLACK_KNIGHTS)))
+         | (KingAttacks[square] & (pieces(WHITE_KING) | pieces(BLACK_KING)))
+         | (getRookAttacks(square, occupancy) & rooksQueens)
+         | (getBishopAttacks(square, occupancy) & bishopsQueens);
+}
+
+bool Position::inCheck() const
+{
+    uint64_t king = pieces(_sideToMove == WHITE ? WHITE_KING : BLACK_KING);
+    if (king == 0) {
+        return false;
+    }
+    return (attackersTo(getFirstBit(king), occupancy()) & enemies()) != 0;
+}
+
+int Position::kingSquare(int side) const
+{
+    uint64_t king = pieces(side == WHITE ? WHITE_KING : BLACK_KING);
+    return king ? getFirstBit(king) : NO_SQUARE;
+}
+
+// only remembers the square if a pawn of the side to move can actually take there,
+// so positions that differ by an unusable en passant square hash the same
+void Position::setEnPassant(int square)
+{
+    uint64_t squareBit = 1ULL << square;
+    uint64_t capturers = _sideToMove == WHITE ? BLACK_PAWN_ATTACKS(squareBit) & pieces(WHITE_PAWNS)
+                                              : WHITE_PAWN_ATTACKS(squareBit) & pieces(BLACK_PAWNS);
+    if (capturers) {
+        _epSquare = square;
+    }
+}
+
+inline void Position::addPiece(int piece, int square)
+{
+    uint64_t bit = 1ULL << square;
+    _bitboards[piece] |= bit;
+    _bitboards[pieceColorOf(piece) == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES] |= bit;
+    _bitboards[OCCUPANCY] |= bit;
+    _bitboards[EMPTY_SQUARES] &= ~bit;
+    _mailbox[square] = piece;
+    _psqt += Psqt.score[piece][square];
+    _phase += PhaseWeights[pieceTypeOf(piece)];
+    if (piece == WHITE_PAWNS || piece == BLACK_PAWNS) {
+        _pawnKey ^= Zobrist.pieceSquare[piece][square];
+    }
+}
+
+inline void Position::removePiece(int piece, int square)
+{
+    uint64_t bit = 1ULL << square;
+    _bitboards[piece] &= ~bit;
+    _bitboards[pieceColorOf(piece) == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES] &= ~bit;
+    _bitboards[OCCUPANCY] &= ~bit;
+    _bitboards[EMPTY_SQUARES] |= bit;
+    _mailbox[square] = EMPTY_SQUARES;
+    _psqt -= Psqt.score[piece][square];
+    _phase -= PhaseWeights[pieceTypeOf(piece)];
+    if (piece == WHITE_PAWNS || piece == BLACK_PAWNS) {
+        _pawnKey ^= Zobrist.pieceSquare[piece][square];
+    }
+}
+
+inline void Position::movePiece(int piece, int from, int to)
+{
+    uint64_t fromTo = (1ULL << from) | (1ULL << to);
+    _bitboards[piece] ^= fromTo;
+    _bitboards[pieceColorOf(piece) == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES] ^= fromTo;
+    _bitboards[OCCUPANCY] ^= fromTo;
+    _bitboards[EMPTY_SQUARES] ^= fromTo;
+    _mailbox[from] = EMPTY_SQUARES;
+    _mailbox[to] = piece;
+    _psqt += Psqt.score[piece][to] - Psqt.score[piece][from];
+    if (piece == WHITE_PAWNS || piece == BLACK_PAWNS) {
+        _pawnKey ^= Zobrist.pieceSquare[piece][from] ^ Zobrist.pieceSquare[piece][to];
+    }
+}
+
+void Position::makeMove(const BitMove& move)
+{
+    int from = move.from();
+    int to = move.to();
+    // an en passant capture takes the pawn that just passed the target square
+    int captureSquare = move.isEnPassant() ? to - 8 * _sideToMove : to;
+
+    UndoInfo& undo = _undo[_ply++];
+    undo.move = move;
+    undo.movedPiece = _mailbox[from];
+    undo.capturedPiece = _mailbox[captureSquare];
+    undo.castlingRights = _castlingRights;
+    undo.epSquare = _epSquare;
+    undo.key = _key;
+
+    if (_epSquare != NO_SQUARE) {
+        _key ^= Zobrist.enPassantFile[_epSquare & 7];
+        _epSquare = NO_SQUARE;
+    }
+    if (undo.capturedPiece != EMPTY_SQUARES) {
+        removePiece(undo.capturedPiece, captureSquare);
+        _key ^= Zobrist.pieceSquare[undo.capturedPiece][captureSquare];
+    }
+    if (move.isPromotion()) {
+        int promoted = pieceIndexFor(move.promotionPiece(), _sideToMove);
+        removePiece(undo.movedPiece, from);
+        addPiece(promoted, to);
+        _key ^= Zobrist.pieceSquare[undo.movedPiece][from] ^ Zobrist.pieceSquare[promoted][to];
+    } else {
+        movePiece(undo.movedPiece, from, to);
+        _key ^= Zobrist.pieceSquare[undo.movedPiece][from] ^ Zobrist.pieceSquare[undo.movedPiece][to];
+    }
+    if (move.isCastle()) {
+        int rook = pieceIndexFor(Rook, _sideToMove);
+        int rookFrom = move.flags() == KING_CASTLE ? to + 1 : to - 2;
+        int rookTo = move.flags() == KING_CASTLE ? to - 1 : to + 1;
+        movePiece(rook, rookFrom, rookTo);
+        _key ^= Zobrist.pieceSquare[rook][rookFrom] ^ Zobrist.pieceSquare[rook][rookTo];
+    }
+
+    uint8_t rights = _castlingRights & CastlingMasks.mask[from] & CastlingMasks.mask[to];
+    if (rights != _castlingRights) {
+        _key ^= Zobrist.castling[_castlingRights] ^ Zobrist.castling[rights];
+        _castlingRights = rights;
+    }
+
+    _key ^= Zobrist.blackToMove;
+    _sideToMove = -_sideToMove;
+
+    if (move.flags() == DOUBLE_PAWN_PUSH) {
+        setEnPassant((from + to) / 2);
+        if (_epSquare != NO_SQUARE) {
+            _key ^= Zobrist.enPassantFile[_epSquare & 7];
+        }
+    }
+}
+
+void Position::unmakeMove()
+{
+    const UndoInfo& undo = _undo[--_ply];
+    const BitMove& move = undo.move;
+    int from = move.from();
+    int to = move.to();
+    _sideToMove = -_sideToMove;
+
+    if (move.isCastle()) {
+        int rook = pieceIndexFor(Rook, _sideToMove);
+        int rookFrom = move.flags() == KING_CASTLE ? to + 1 : to - 2;
+        int rookTo = move.flags() == KING_CASTLE ? to - 1 : to + 1;
+        movePiece(rook, rookTo, rookFrom);
+    }
+    if (move.isPromotion()) {
+        removePiece(_mailbox[to], to);
+        addPiece(undo.movedPiece, from);
+    } else {
+        movePiece(undo.movedPiece, to, from);
+    }
+    if (undo.capturedPiece != EMPTY_SQUARES) {
+        addPiece(undo.capturedPiece, move.isEnPassant() ? to - 8 * _sideToMove : to);
+    }
+    _castlingRights = undo.castlingRights;
+    _epSquare = undo.epSquare;
+    _key = undo.key;
+}
+
+void Position::commitMove(const BitMove& move)
+{
+    makeMove(move);
+    _ply = 0;
+}
+
+void Position::makeNullMove()
+{
+    UndoInfo& undo = _undo[_ply++];
+    undo.move = BitMove::none();
+    undo.movedPiece = EMPTY_SQUARES;
+    undo.capturedPiece = EMPTY_SQUARES;
+    undo.castlingRights = _castlingRights;
+    undo.epSquare = _epSquare;
+    undo.key = _key;
+
+    if (_epSquare != NO_SQUARE) {
+        _key ^= Zobrist.enPassantFile[_epSquare & 7];
+        _epSquare = NO_SQUARE;
+    }
+    _key ^= Zobrist.blackToMove;
+    _sideToMove = -_sideToMove;
+}
+
+void Position::unmakeNullMove()
+{
+    const UndoInfo& undo = _undo[--_ply];
+    _sideToMove = -_sideToMove;
+    _epSquare = undo.epSquare;
+    _key = undo.key;
+}
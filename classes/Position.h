@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "BitBoard.h"
+
+constexpr int WHITE = +1;
+constexpr int BLACK = -1;
+constexpr int MAX_PLY = 256;
+constexpr int NO_SQUARE = 64;
+
+enum CastlingRight
+{
+    WHITE_OO = 1,
+    WHITE_OOO = 2,
+    BLACK_OO = 4,
+    BLACK_OOO = 8,
+    ALL_CASTLING = 15
+};
+
+enum AllBitBoards {
+    WHITE_PAWNS,
+    WHITE_KNIGHTS,
+    WHITE_BISHOPS,
+    WHITE_ROOKS,
+    WHITE_QUEENS,
+    WHITE_KING,
+    BLACK_PAWNS,
+    BLACK_KNIGHTS,
+    BLACK_BISHOPS,
+    BLACK_ROOKS,
+    BLACK_QUEENS,
+    BLACK_KING,
+    WHITE_ALL_PIECEES,
+    BLACK_ALL_PIECES,
+    OCCUPANCY,
+    EMPTY_SQUARES,
+    eNUM_BITBOARDS
+};
+
+// piece index (WHITE_PAWNS..BLACK_KING) helpers, EMPTY_SQUARES marks an empty mailbox square
+constexpr ChessPiece pieceTypeOf(int piece) { return (ChessPiece)(piece % 6 + 1); }
+constexpr int pieceColorOf(int piece) { return piece < BLACK_PAWNS ? WHITE : BLACK; }
+constexpr int pieceIndexFor(ChessPiece type, int color) { return (color == WHITE ? (int)WHITE_PAWNS : (int)BLACK_PAWNS) + type - 1; }
+
+// coordinate notation, e.g. "e2e4"
+std::string moveToString(const BitMove& move);
+
+// everything makeMove changes that can't be recomputed from the move itself
+struct UndoInfo
+{
+    BitMove move;
+    uint8_t movedPiece;
+    uint8_t capturedPiece;
+    uint8_t castlingRights;
+    uint8_t epSquare;
+    uint64_t key;
+};
+
+//
+// the board as the search sees it: 12 piece bitboards plus the aggregates,
+// a mailbox for "what's on this square" lookups and a stack of undo records.
+// makeMove/unmakeMove only touch the squares involved in the move.
+//
+class Position
+{
+public:
+    Position();
+
+    // state strings are the 64 char strings Chess::stateString() produces (a1 first).
+    // they carry no castling history, so a king and rook on their home squares get the right
+    void setFromStateString(const std::string& state, int sideToMove);
+    std::string stateString() const;
+    // piece placement, side to move, castling and en passant fields of a FEN string
+    void setFromFEN(const std::string& fen);
+
+    void makeMove(const BitMove& move);
+    void unmakeMove();
+    // plays move for good, it can't be unmade, so a game can run past MAX_PLY
+    void commitMove(const BitMove& move);
+    // passes the turn, for null-move pruning
+    void makeNullMove();
+    void unmakeNullMove();
+
+    const BitBoard& bitboard(int index) const { return _bitboards[index]; }
+    uint64_t pieces(int index) const { return _bitboards[index].getData(); }
+    uint64_t occupancy() const { return _bitboards[OCCUPANCY].getData(); }
+    uint64_t emptySquares() const { return _bitboards[EMPTY_SQUARES].getData(); }
+    uint64_t friendlies() const { return _bitboards[_sideToMove == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES].getData(); }
+    uint64_t enemies() const { return _bitboards[_sideToMove == WHITE ? BLACK_ALL_PIECES : WHITE_ALL_PIECEES].getData(); }
+
+    // every piece of either colour attacking square, given occupancy for the sliders
+    uint64_t attackersTo(int square, uint64_t occupancy) const;
+    // the side to move's king is attacked (false if it has no king)
+    bool inCheck() const;
+    int kingSquare(int side) const;
+
+    int pieceAt(int square) const { return _mailbox[square]; }
+    int sideToMove() const { return _sideToMove; }
+    int castlingRights() const { return _castlingRights; }
+    // the square a pawn can capture en passant on, NO_SQUARE if there is no such capture
+    int epSquare() const { return _epSquare; }
+    int ply() const { return _ply; }
+    // the move that led here, none after a null move or at the start of the stack
+    BitMove lastMove() const { return _ply > 0 ? _undo[_ply - 1].move : BitMove::none(); }
+    // the record of the move made at ply (below ply()), its key is the position's at that ply
+    const UndoInfo& undoInfo(int ply) const { return _undo[ply]; }
+    // Zobrist hash of the position, kept up to date by make/unmake
+    uint64_t key() const { return _key; }
+    uint64_t computeKey() const;
+    // Zobrist hash of the pawns alone, for the pawn evaluation cache
+    uint64_t pawnKey() const { return _pawnKey; }
+    uint64_t computePawnKey() const;
+    // material plus piece-square score from white's point of view, middlegame and
+    // endgame packed together (see Evaluate.h), and the game phase from the non-pawn
+    // material. both kept up to date by make/unmake like the key
+    int psqtScore() const { return _psqt; }
+    int computePsqt() const;
+    int phase() const { return _phase; }
+    int computePhase() const;
+
+private:
+    void clear();
+    inline void addPiece(int piece, int square);
+    inline void removePiece(int piece, int square);
+    inline void movePiece(int piece, int from, int to);
+    void setEnPassant(int square);
+
+    BitBoard _bitboards[eNUM_BITBOARDS];
+    uint8_t _mailbox[64];
+    int _sideToMove;
+    uint8_t _castlingRights;
+    uint8_t _epSquare;
+    int _ply;
+    uint64_t _key;
+    uint64_t _pawnKey;
+    int _psqt;
+    int _phase;
+    UndoInfo _undo[MAX_PLY];
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// square to square ray tables, generated at compile time.
+// between[a][b] is the squares strictly between a and b, line[a][b] the whole
+// board line through both (a and b included), both empty when a and b don't
+// share a rank, file or diagonal. pins and check blocks are built from these
+//
+struct RayTables
+{
+    uint64_t between[64][64];
+    uint64_t line[64][64];
+};
+
+constexpr RayTables makeRayTables()
+{
+    RayTables rays{};
+    const int fileSteps[8] = { 1, -1, 0, 0, 1, -1, 1, -1 };
+    const int rankSteps[8] = { 0, 0, 1, -1, 1, -1, -1, 1 };
+    for (int from = 0; from < 64; from++) {
+        for (int direction = 0; direction < 8; direction++) {
+            int fileStep = fileSteps[direction];
+            int rankStep = rankSteps[direction];
+
+            // the full line runs both ways from the start square
+            uint64_t line = 1ULL << from;
+            for (int sign = -1; sign <= 1; sign += 2) {
+                int file = from % 8 + sign * fileStep;
+                int rank = from / 8 + sign * rankStep;
+                while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+                    line |= 1ULL << (rank * 8 + file);
+                    file += sign * fileStep;
+                    rank += sign * rankStep;
+                }
+            }
+
+            uint64_t between = 0;
+            int file = from % 8 + fileStep;
+            int rank = from / 8 + rankStep;
+            while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+                int to = rank * 8 + file;
+                rays.between[from][to] = between;
+                rays.line[from][to] = line;
+                between |= 1ULL << to;
+                file += fileStep;
+                rank += rankStep;
+            }
+        }
+    }
+    return rays;
+}
+
+inline constexpr RayTables Rays = makeRayTables();
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+//
+// fixed capacity single producer / single consumer ring buffer.
+// push and pop never block or allocate; push fails when the queue is full.
+//
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+public:
+    bool push(const T& item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t next = (head + 1) % Capacity;
+        if (next == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        _items[head] = item;
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail];
+        _tail.store((tail + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T _items[Capacity];
+    // producer and consumer indices on separate cache lines
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+};
@@ -0,0 +1,590 @@
+#include "Search.h"
+#include "MoveGenerator.h"
+#include "Evaluate.h"
+#include "StaticExchange.h"
+#include "MovePicker.h"
+#include "MagicBitboards.h"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// helper threads skip some iterations so they don't all search the same depth
+// at the same time (SkipSize consecutive depths searched, then as many skipped)
+static const int SkipSize[] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+static const int SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// late move reductions by depth and move number, ln(depth) * ln(moveNumber) so a
+// quiet move searched late at high depth loses several plies
+struct ReductionTable
+{
+    int table[64][64];
+
+    ReductionTable()
+    {
+        for (int depth = 0; depth < 64; depth++) {
+            for (int moveNumber = 0; moveNumber < 64; moveNumber++) {
+                table[depth][moveNumber] = depth && moveNumber
+                    ? (int)(0.75 + std::log(depth) * std::log(moveNumber) / 2.25) : 0;
+            }
+        }
+    }
+
+    int operator()(int depth, int moveNumber) const { return table[std::min(depth, 63)][std::min(moveNumber, 63)]; }
+};
+static const ReductionTable Reductions;
+
+// a side with no more than one minor piece besides its pawns is where passing
+// is most likely the best move, so null-move cutoffs there get verified
+static bool zugzwangProne(const Position& position)
+{
+    int side = position.sideToMove();
+    uint64_t heavies = position.pieces(pieceIndexFor(Rook, side)) | position.pieces(pieceIndexFor(Queen, side));
+    uint64_t minors = position.pieces(pieceIndexFor(Knight, side)) | position.pieces(pieceIndexFor(Bishop, side));
+    return heavies == 0 && countOnes(minors) <= 1;
+}
+
+// mate scores go into the table as distance from the node rather than from the
+// root, so a mate reached again at another ply still counts its plies right
+static int scoreToTT(int score, int ply)
+{
+    return score >= MateBound ? score + ply : (score <= -MateBound ? score - ply : score);
+}
+
+static int scoreFromTT(int score, int ply)
+{
+    return score >= MateBound ? score - ply : (score <= -MateBound ? score + ply : score);
+}
+
+// what a capture or promotion wins before anything is taken back
+static int materialGain(const Position& position, const BitMove& move)
+{
+    int gain = 0;
+    if (move.isEnPassant()) {
+        gain = PieceValues[Pawn];
+    } else if (move.isCapture()) {
+        gain = PieceValues[pieceTypeOf(position.pieceAt(move.to()))];
+    }
+    if (move.isPromotion()) {
+        gain += PieceValues[move.promotionPiece()] - PieceValues[Pawn];
+    }
+    return gain;
+}
+
+SearchWorker::SearchWorker(Search& search, int id)
+    : _search(search), _id(id), _rootPly(0), _nodes(0), _aborted(false), _betaCutoffs(0), _firstMoveCutoffs(0)
+{
+    clearHistory();
+}
+
+void SearchWorker::clearHistory()
+{
+    _history.clear();
+    _counterMoves.clear();
+}
+
+void SearchWorker::checkStop()
+{
+    if (isMainThread() && !_search.pondering() && _search._timeManager.hardExpired()) {
+        _search.stopWorkers();
+    }
+    _aborted = _search.stopped();
+}
+
+// the line at ply becomes move followed by the line found one ply deeper
+void SearchWorker::updatePV(int ply, const BitMove& move)
+{
+    PVLine& line = _pv[ply];
+    const PVLine& child = _pv[ply + 1];
+    line.moves[0] = move;
+    line.length = std::min(child.length + 1, MAX_PLY);
+    std::copy(child.moves, child.moves + line.length - 1, line.moves + 1);
+}
+
+void SearchWorker::reportIteration(int depth, int score)
+{
+    if (!_search._infoHandler) {
+        return;
+    }
+    SearchInfo info;
+    info.depth = depth;
+    info.score = score;
+    info.nodes = _search.nodes();
+    info.timeMs = _search._timeManager.elapsedMs();
+    info.hashfull = _search.hashfull();
+    info.pvLength = _result.pvLength;
+    std::copy(_result.pv, _result.pv + _result.pvLength, info.pv);
+    _search._infoHandler(info);
+}
+
+void SearchWorker::iterativeDeepening(const Position& root, const MoveList& rootMoves)
+{
+    const SearchLimits& limits = _search._limits;
+    TimeManager& timeManager = _search._timeManager;
+
+    _position = root;
+    _rootPly = root.ply();
+    _rootMoves = rootMoves;
+    _nodes.store(0, std::memory_order_relaxed);
+    _aborted = false;
+    _betaCutoffs = 0;
+    _firstMoveCutoffs = 0;
+    _pawnTable.resetStats();
+    _result = SearchResult();
+    for (auto& killers : _killers) {
+        killers.clear();
+    }
+    if (!isMainThread()) {
+        // helpers also start from a different root move for some move order diversity
+        std::rotate(_rootMoves.begin(), _rootMoves.begin() + _id % _rootMoves.size(), _rootMoves.end());
+    }
+
+    int maxDepth = limits.maxDepth > 0 ? limits.maxDepth : (timeManager.isTimed() ? MAX_PLY / 2 : DefaultSearchDepth);
+    BitMove bestMove;
+    int previousScore = 0;
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        if (!isMainThread()) {
+            int i = (_id - 1) % 20;
+            if (((depth + SkipPhase[i]) / SkipSize[i]) % 2) {
+                continue;
+            }
+        }
+        BitMove iterationMove = bestMove;
+        int iterationVal = aspirationSearch(depth, previousScore, iterationMove);
+        if (_aborted || _search.stopped()) {
+            // moves an aborted iteration finished are still at least as good as the
+            // previous best it searched first
+            if (iterationVal != negInfite) {
+                _result.bestMove = iterationMove;
+                if (_result.score == negInfite) {
+                    _result.score = iterationVal;
+                    _result.depth = depth;
+                }
+                if (_result.pvLength == 0 || !(_result.pv[0] == iterationMove)) {
+                    _result.pv[0] = iterationMove;
+                    _result.pvLength = 1;
+                }
+            }
+            break;
+        }
+        bestMove = iterationMove;
+        previousScore = iterationVal;
+        _result.bestMove = bestMove;
+        _result.score = iterationVal;
+        _result.depth = depth;
+        _result.pvLength = std::min(_pv[0].length, MAX_PV);
+        std::copy(_pv[0].moves, _pv[0].moves + _result.pvLength, _result.pv);
+
+        if (isMainThread()) {
+            timeManager.iterationFinished(bestMove);
+            reportIteration(depth, iterationVal);
+            if (depth >= limits.minDepth && !_search.pondering() && timeManager.softExpired()) {
+                break;
+            }
+        }
+    }
+
+    // the main thread owns the time decision, once it's done everyone is
+    if (isMainThread()) {
+        _search.stopWorkers();
+    }
+}
+
+// searches the root in a narrow window around the previous iteration's score,
+// widening whichever side fails until the score lands inside it
+int SearchWorker::aspirationSearch(int depth, int previousScore, BitMove& bestMove)
+{
+    int delta = AspirationWindow;
+    int alpha = negInfite;
+    int beta = posInfite;
+    if (depth >= AspirationMinDepth) {
+        alpha = std::max(previousScore - delta, negInfite);
+        beta = std::min(previousScore + delta, posInfite);
+    }
+
+    while (true) {
+        int score = searchRoot(depth, alpha, beta, bestMove);
+        if (_aborted) {
+            return score;
+        }
+        if (score <= alpha && alpha > negInfite) {
+            beta = (alpha + beta) / 2;
+            alpha = std::max(score - delta, negInfite);
+        } else if (score >= beta && beta < posInfite) {
+            beta = std::min(score + delta, posInfite);
+        } else {
+            return score;
+        }
+        delta += delta / 2;
+    }
+}
+
+// searches every root move to depth plies inside (alpha, beta), bestMove comes in
+// as the previous iteration's choice (searched first) and only changes to a move
+// that scores above alpha
+int SearchWorker::searchRoot(int depth, int alpha, int beta, BitMove& bestMove)
+{
+    auto previousBest = std::find(_rootMoves.begin(), _rootMoves.end(), bestMove);
+    if (previousBest != _rootMoves.end()) {
+        std::rotate(_rootMoves.begin(), previousBest, previousBest + 1);
+    }
+
+    int alphaOrig = alpha;
+    int bestVal = negInfite;
+    bool firstMove = true;
+    _pv[0].length = 0;
+    for(auto move : _rootMoves) {
+        _position.makeMove(move);
+        int moveVal;
+        if (firstMove) {
+            moveVal = -negamax(depth - 1, -beta, -alpha);
+        } else {
+            moveVal = -negamax(depth - 1, -alpha - 1, -alpha);
+            if (moveVal > alpha && moveVal < beta) {
+                moveVal = -negamax(depth - 1, -beta, -alpha);
+            }
+        }
+        _position.unmakeMove();
+        if (_aborted) {
+            break;
+        }
+        firstMove = false;
+        if (moveVal > bestVal) {
+            bestVal = moveVal;
+            if (moveVal > alpha) {
+                bestMove = move;
+                updatePV(0, move);
+                if (moveVal >= beta) {
+                    break;
+                }
+                alpha = moveVal;
+            }
+        }
+    };
+    if (!_aborted) {
+        TTBound bound = bestVal <= alphaOrig ? BOUND_UPPER : (bestVal >= beta ? BOUND_LOWER : BOUND_EXACT);
+        _search._transpositionTable.store(_position.key(), depth, bound, bestVal, bestMove);
+    }
+    return bestVal;
+}
+
+// principal variation search: the first move gets the full window, the rest are
+// expected to fail low and only get a null window, re-searched if they don't
+int SearchWorker::negamax(int depth, int alpha, int beta, bool allowNullMove)
+{
+    int ply = _position.ply() - _rootPly;
+    _pv[ply].length = 0;
+    countNode();
+    if ((nodes() & (StopCheckInterval - 1)) == 0) {
+        checkStop();
+    }
+    if (_aborted) {
+        return 0;
+    }
+    if(depth <= 0) {
+        return quiescence(alpha, beta);
+    }
+    if (ply >= MAX_PLY - 1) {
+        return evaluate();
+    }
+    bool pvNode = beta - alpha > 1;
+
+    // a deep enough result from another move order (or thread) can answer this node outright
+    TranspositionTable& transpositionTable = _search._transpositionTable;
+    int alphaOrig = alpha;
+    BitMove ttMove;
+    TTEntry entry;
+    if (transpositionTable.probe(_position.key(), entry)) {
+        ttMove = entry.move;
+        // never at PV nodes though, that would cut the principal variation short
+        int ttScore = scoreFromTT(entry.score, ply);
+        if (!pvNode && entry.depth >= depth) {
+            if (entry.bound() == BOUND_EXACT ||
+                (entry.bound() == BOUND_LOWER && ttScore >= beta) ||
+                (entry.bound() == BOUND_UPPER && ttScore <= alpha)) {
+                return ttScore;
+            }
+        }
+    }
+
+    const PruningOptions& pruning = _search._pruning;
+    bool inCheck = _position.inCheck();
+
+    // null move: if passing still fails high the position is good enough to cut
+    // without searching a real move. in zugzwang-prone endgames passing can be
+    // better than anything legal, so there a reduced normal search has to agree
+    if (pruning.nullMove && allowNullMove && !pvNode && !inCheck && depth >= NullMoveMinDepth &&
+        evaluate() >= beta) {
+        int nullDepth = depth - 1 - (NullMoveReduction + depth / 6);
+        _position.makeNullMove();
+        int value = -negamax(nullDepth, -beta, -beta + 1, false);
+        _position.unmakeNullMove();
+        if (_aborted) {
+            return 0;
+        }
+        if (value >= beta) {
+            // a mate found after passing isn't proven for the real position
+            if (value >= MateBound) {
+                value = beta;
+            }
+            if (!zugzwangProne(_position)) {
+                return value;
+            }
+            int verified = negamax(nullDepth, beta - 1, beta, false);
+            if (_aborted) {
+                return 0;
+            }
+            if (verified >= beta) {
+                return value;
+            }
+        }
+    }
+
+    KillerMoves* killers = ply < MAX_PLY ? &_killers[ply] : nullptr;
+    BitMove previousMove = _position.lastMove();
+    int previousPiece = previousMove.isNone() ? EMPTY_SQUARES : _position.pieceAt(previousMove.to());
+    BitMove counterMove = previousMove.isNone() ? BitMove::none() : _counterMoves.get(previousPiece, previousMove.to());
+    MovePicker picker(_position, ALL_MOVES, ttMove, killers, &_history, counterMove);
+
+    int bestVal = negInfite; // Min value
+    BitMove bestMove;
+    BitMove move;
+    while (picker.next(move)) {
+        int moveNumber = picker.movesPicked();
+        bool quiet = move.isQuiet();
+        // captures that lose material by static exchange get reduced like quiet moves
+        bool reducible = quiet || picker.pickingBadCaptures();
+        // late move pruning: this late in a well ordered list a quiet move at low
+        // depth almost never matters
+        if (pruning.lateMovePruning && !pvNode && !inCheck && quiet && bestVal > negInfite &&
+            depth <= LateMovePruningDepth && moveNumber > LateMovePruningBase + depth * depth) {
+            continue;
+        }
+
+        _position.makeMove(move);
+        int value;
+        if (moveNumber == 1) {
+            value = -negamax(depth - 1, -beta, -alpha);
+        } else {
+            // late move reductions: late quiet moves and losing captures get a shallower
+            // null window search first, and a full depth one only if that fails high
+            int reduction = 0;
+            if (pruning.lateMoveReductions && reducible && !inCheck && depth >= LateMoveReductionDepth &&
+                !_position.inCheck()) {
+                reduction = Reductions(depth, moveNumber) - (pvNode ? 1 : 0);
+                reduction = std::clamp(reduction, 0, depth - 2);
+            }
+            value = -negamax(depth - 1 - reduction, -alpha - 1, -alpha);
+            if (reduction > 0 && value > alpha) {
+                value = -negamax(depth - 1, -alpha - 1, -alpha);
+            }
+            if (value > alpha && value < beta) {
+                value = -negamax(depth - 1, -beta, -alpha);
+            }
+        }
+        _position.unmakeMove();
+        if (_aborted) {
+            break;
+        }
+
+        if (value > bestVal) {
+            bestVal = value;
+            bestMove = move;
+        }
+        if (value > alpha) {
+            alpha = value;
+            if (pvNode) {
+                updatePV(ply, move);
+            }
+        }
+        if(alpha >= beta) {
+            _betaCutoffs++;
+            if (moveNumber == 1) {
+                _firstMoveCutoffs++;
+            }
+            // quiet moves that refute a line are worth trying early in sibling nodes too
+            if (quiet) {
+                if (killers) {
+                    killers->add(move);
+                }
+                if (!previousMove.isNone()) {
+                    _counterMoves.set(previousPiece, previousMove.to(), move);
+                }
+                _history.update(_position.sideToMove(), move, std::min(depth * depth, MaxHistory));
+            }
+            break; // Beta cutoff
+        }
+    };
+
+    if (_aborted) {
+        return 0;
+    }
+    // every generated move is legal, so none at all is mate or stalemate
+    if (bestMove.isNone()) {
+        return inCheck ? -MateScore + ply : 0;
+    }
+    TTBound bound = bestVal <= alphaOrig ? BOUND_UPPER : (bestVal >= beta ? BOUND_LOWER : BOUND_EXACT);
+    transpositionTable.store(_position.key(), depth, bound, scoreToTT(bestVal, ply), bestMove);
+    return bestVal;
+}
+
+int SearchWorker::evaluate()
+{
+    if (networkLoaded()) {
+        return _nnue.evaluate(_position);
+    }
+    // evaluateBoard scores from white's point of view, negamax wants the side to move's
+    return evaluateBoard(_position, &_pawnTable) * _position.sideToMove();
+}
+
+// captures only search at the leaves so the static evaluation is never taken
+// in the middle of an exchange. in check there's no standing pat, every evasion
+// gets searched instead
+int SearchWorker::quiescence(int alpha, int beta)
+{
+    int ply = _position.ply() - _rootPly;
+    _pv[ply].length = 0;
+    countNode();
+    if ((nodes() & (StopCheckInterval - 1)) == 0) {
+        checkStop();
+    }
+    if (_aborted) {
+        return 0;
+    }
+
+    int standPat = evaluate();
+    bool inCheck = _position.inCheck();
+    if (ply >= MAX_PLY - 1) {
+        return standPat;
+    }
+    int bestVal = negInfite;
+    if (!inCheck) {
+        if (standPat >= beta) {
+            return standPat;
+        }
+        alpha = std::max(alpha, standPat);
+        bestVal = standPat;
+    }
+
+    // captures come out most valuable victim first, least valuable attacker breaking ties
+    MovePicker picker(_position, inCheck ? EVASIONS : CAPTURES, BitMove::none(), nullptr, nullptr);
+
+    BitMove move;
+    while (picker.next(move)) {
+        if (!inCheck) {
+            // losing captures come last and aren't going to be better than standing pat
+            if (picker.pickingBadCaptures()) {
+                break;
+            }
+            // delta pruning: even winning the victim outright doesn't get us to alpha
+            if (standPat + materialGain(_position, move) + DeltaMargin <= alpha) {
+                continue;
+            }
+        }
+        _position.makeMove(move);
+        int value = -quiescence(-beta, -alpha);
+        _position.unmakeMove();
+
+        if (_aborted) {
+            return 0;
+        }
+
+        if (value > bestVal) {
+            bestVal = value;
+            if (value >= beta) {
+                break;
+            }
+            alpha = std::max(alpha, value);
+        }
+    }
+    if (inCheck && bestVal == negInfite) {
+        return -MateScore + ply;
+    }
+    return bestVal;
+}
+
+Search::Search()
+    : _stop(false), _pondering(false)
+{
+    _transpositionTable.resize(16);
+    setThreads(1);
+}
+
+Search::~Search()
+{
+}
+
+void Search::newGame()
+{
+    _transpositionTable.clear();
+    for (auto& worker : _workers) {
+        worker->clearHistory();
+    }
+}
+
+void Search::setThreads(int count)
+{
+    count = std::max(count, 1);
+    if (count == (int)_workers.size()) {
+        return;
+    }
+    _workers.clear();
+    for (int i = 0; i < count; i++) {
+        _workers.push_back(std::make_unique<SearchWorker>(*this, i));
+    }
+}
+
+uint64_t Search::nodes() const
+{
+    uint64_t total = 0;
+    for (auto& worker : _workers) {
+        total += worker->nodes();
+    }
+    return total;
+}
+
+void Search::ponderHit()
+{
+    _timeManager.restart();
+    _pondering.store(false, std::memory_order_release);
+}
+
+SearchResult Search::think(const Position& position, const SearchLimits& limits)
+{
+    _limits = limits;
+    _timeManager.start(limits);
+    _transpositionTable.newSearch();
+    _stop.store(false, std::memory_order_relaxed);
+
+    MoveList rootMoves;
+    generateAllMoves(position, rootMoves);
+    if (rootMoves.empty()) {
+        return SearchResult();
+    }
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < _workers.size(); i++) {
+        SearchWorker* worker = _workers[i].get();
+        helpers.emplace_back([worker, &position, &rootMoves]() {
+            worker->iterativeDeepening(position, rootMoves);
+        });
+    }
+    _workers[0]->iterativeDeepening(position, rootMoves);
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    // a ponder search that finished early still can't move before the opponent has
+    while (pondering()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    SearchResult result = _workers[0]->result();
+    result.nodes = nodes();
+    for (auto& worker : _workers) {
+        result.betaCutoffs += worker->betaCutoffs();
+        result.firstMoveCutoffs += worker->firstMoveCutoffs();
+        result.pawnProbes += worker->pawnTable().probes();
+        result.pawnHits += worker->pawnTable().hits();
+    }
+    result.timeMs = _timeManager.elapsedMs();
+    return result;
+}
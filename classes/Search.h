@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Position.h"
+#include "TranspositionTable.h"
+#include "TimeManager.h"
+#include "MovePicker.h"
+#include "PawnTable.h"
+#include "Nnue.h"
+
+constexpr int negInfite = -100000;
+constexpr int posInfite = +100000;
+// mate in n plies from the root scores MateScore - n, anything past MateBound is a mate.
+// both fit the 16 bit score a TT entry keeps
+constexpr int MateScore = 30000;
+constexpr int MateBound = MateScore - MAX_PLY;
+// depth used when there is neither a clock nor a depth cap
+constexpr int DefaultSearchDepth = 4;
+// how often (in nodes) workers look at the stop flag and the clock
+constexpr uint64_t StopCheckInterval = 1024;
+constexpr int MAX_PV = 32;
+// quiescence skips captures that can't raise the score to alpha even with this much to spare
+constexpr int DeltaMargin = 200;
+// iterations from this depth on search inside a window this wide around the last score
+constexpr int AspirationMinDepth = 4;
+constexpr int AspirationWindow = 50;
+// null move: skipped below this depth, reduced by NullMoveReduction + depth / 6 plies
+constexpr int NullMoveMinDepth = 3;
+constexpr int NullMoveReduction = 3;
+// late move reductions start at this depth
+constexpr int LateMoveReductionDepth = 3;
+// late move pruning: up to this depth, quiet moves past LateMovePruningBase + depth^2 are skipped
+constexpr int LateMovePruningDepth = 3;
+constexpr int LateMovePruningBase = 3;
+
+// forward pruning switches, all on by default (the pruning bench turns them off to compare)
+struct PruningOptions
+{
+    bool nullMove = true;
+    bool lateMoveReductions = true;
+    bool lateMovePruning = true;
+};
+
+struct SearchResult
+{
+    BitMove bestMove;
+    int score = negInfite;
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    int pvLength = 0;
+    BitMove pv[MAX_PV];
+    // move ordering quality: how many fail-high nodes cut off on the first move tried
+    uint64_t betaCutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;
+    // pawn evaluation cache use, summed over the threads
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+};
+
+// progress report sent after every finished iteration of the main thread
+struct SearchInfo
+{
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    int hashfull = 0;
+    int pvLength = 0;
+    BitMove pv[MAX_PV];
+};
+
+class Search;
+
+// one row of the triangular PV table: the best line found from some ply on
+struct PVLine
+{
+    int length = 0;
+    BitMove moves[MAX_PLY];
+};
+
+//
+// one search thread. every worker has its own copy of the position and its own
+// counters, the only thing they share is the transposition table (lazy SMP).
+// worker 0 is the main thread and the only one that looks at the clock.
+//
+class SearchWorker
+{
+public:
+    SearchWorker(Search& search, int id);
+
+    void iterativeDeepening(const Position& root, const MoveList& rootMoves);
+
+    uint64_t nodes() const { return _nodes.load(std::memory_order_relaxed); }
+    const SearchResult& result() const { return _result; }
+    uint64_t betaCutoffs() const { return _betaCutoffs; }
+    uint64_t firstMoveCutoffs() const { return _firstMoveCutoffs; }
+    const PawnTable& pawnTable() const { return _pawnTable; }
+    void clearHistory();
+
+private:
+    int aspirationSearch(int depth, int previousScore, BitMove& bestMove);
+    int searchRoot(int depth, int alpha, int beta, BitMove& bestMove);
+    int negamax(int depth, int alpha, int beta, bool allowNullMove = true);
+    int quiescence(int alpha, int beta);
+    // static evaluation for the side to move: the network when one is loaded, else the classical one
+    int evaluate();
+    void updatePV(int ply, const BitMove& move);
+    void checkStop();
+    void reportIteration(int depth, int score);
+    bool isMainThread() const { return _id == 0; }
+    // only this thread writes the counter, so a plain load/store is enough (and cheap)
+    void countNode() { _nodes.store(_nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    Search& _search;
+    int _id;
+    Position _position;
+    int _rootPly; // _position.ply() at the root, killers are indexed by distance from it
+    MoveList _rootMoves;
+    std::atomic<uint64_t> _nodes;
+    bool _aborted; // this worker has seen the stop flag
+    SearchResult _result;
+    KillerMoves _killers[MAX_PLY];
+    PVLine _pv[MAX_PLY + 1]; // _pv[ply] is the line below ply, filled bottom up
+    ButterflyHistory _history; // kept between searches, cleared by newGame()
+    CounterMoves _counterMoves; // same
+    PawnTable _pawnTable; // kept for good, an entry only depends on the pawns
+    NnueStack _nnue; // same, an entry only depends on the pieces
+    uint64_t _betaCutoffs;
+    uint64_t _firstMoveCutoffs;
+};
+
+class Search
+{
+public:
+    Search();
+    ~Search();
+
+    void setThreads(int count);
+    int threads() const { return (int)_workers.size(); }
+    void resizeHash(size_t megabytes) { _transpositionTable.resize(megabytes); }
+    void newGame();
+    void setPruning(const PruningOptions& options) { _pruning = options; }
+    const PruningOptions& pruning() const { return _pruning; }
+    // called from the search thread after every finished iteration
+    void setInfoHandler(std::function<void(const SearchInfo&)> handler) { _infoHandler = handler; }
+
+    // runs all threads on position until the limits say stop, returns the main thread's choice.
+    // blocks, so run it on its own thread to keep a UI responsive; stop() may be called from any thread
+    SearchResult think(const Position& position, const SearchLimits& limits);
+    // also ends pondering, a search stopped while pondering returns at once
+    void stop()
+    {
+        _pondering.store(false, std::memory_order_release);
+        _stop.store(true, std::memory_order_relaxed);
+    }
+    bool stopped() const { return _stop.load(std::memory_order_relaxed); }
+
+    // pondering: set before think() to search the position after the opponent's expected
+    // reply without a clock. ponderHit() means the reply was played, the clock starts now
+    // and the search carries on with everything it has so far. a ponder search that runs
+    // out of depth holds its result until ponderHit() or stop()
+    void setPondering(bool pondering) { _pondering.store(pondering, std::memory_order_release); }
+    void ponderHit();
+    bool pondering() const { return _pondering.load(std::memory_order_acquire); }
+
+    uint64_t nodes() const;
+    int hashfull() const { return _transpositionTable.hashfull(); }
+
+private:
+    friend class SearchWorker;
+
+    // ends the search without touching pondering, for the workers themselves
+    void stopWorkers() { _stop.store(true, std::memory_order_relaxed); }
+
+    TranspositionTable _transpositionTable;
+    TimeManager _timeManager;
+    SearchLimits _limits;
+    PruningOptions _pruning;
+    std::atomic<bool> _stop;
+    std::atomic<bool> _pondering;
+    std::function<void(const SearchInfo&)> _infoHandler;
+    std::vector<std::unique_ptr<SearchWorker>> _workers;
+};
@@ -0,0 +1,133 @@
+#include "SliderFill.h"
+#include "MagicBitboards.h"
+
+#if defined(__x86_64__) || (defined(_MSC_VER) && defined(_M_X64))
+    #include <immintrin.h>
+    #define FILL_HAVE_AVX2 1
+#endif
+
+// the AVX2 code is compiled for AVX2 whatever the rest of the build targets,
+// and only ever run once cpuHasAvx2() said so
+#if defined(__GNUC__) || defined(__clang__)
+    #define FILL_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define FILL_TARGET_AVX2
+#endif
+
+FillBackend SliderFill = bestFillBackend();
+
+constexpr uint64_t NotFileA = ~0x0101010101010101ULL;
+constexpr uint64_t NotFileH = ~0x8080808080808080ULL;
+
+const char* fillBackendName(FillBackend backend)
+{
+    return backend == FILL_AVX2 ? "avx2" : "scalar";
+}
+
+bool cpuHasAvx2()
+{
+#ifdef SLIDERS_HAVE_CPUID
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) {
+        return false;
+    }
+    cpuid(1, 0, regs);
+    bool osxsave = (regs[2] >> 27) & 1;
+    cpuid(7, 0, regs);
+    bool avx2 = (regs[1] >> 5) & 1;
+    if (!osxsave || !avx2) {
+        return false;
+    }
+    // the OS has to save xmm and ymm state on a context switch
+#if defined(_MSC_VER) && !defined(__clang__)
+    uint64_t xcr0 = _xgetbv(0);
+#else
+    unsigned eax, edx;
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)edx << 32) | eax;
+#endif
+    return (xcr0 & 6) == 6;
+#else
+    return false;
+#endif
+}
+
+// positive shifts go up the board, negative ones down
+static inline uint64_t shiftBy(uint64_t bits, int shift)
+{
+    return shift > 0 ? bits << shift : bits >> -shift;
+}
+
+// the squares generators attack in one direction: the fill runs through empty
+// squares in 1, 2 and 4 steps, mask drops whatever wrapped round the board edge
+static inline uint64_t occludedFill(uint64_t generators, uint64_t empty, int shift, uint64_t mask)
+{
+    uint64_t propagators = empty & mask;
+    generators |= propagators & shiftBy(generators, shift);
+    propagators &= shiftBy(propagators, shift);
+    generators |= propagators & shiftBy(generators, 2 * shift);
+    propagators &= shiftBy(propagators, 2 * shift);
+    generators |= propagators & shiftBy(generators, 4 * shift);
+    return shiftBy(generators, shift) & mask;
+}
+
+SliderAttackMaps sliderAttackMapsScalar(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied)
+{
+    uint64_t empty = ~occupied;
+    SliderAttackMaps maps;
+    maps.rooks = occludedFill(rookMovers, empty, 8, ~0ULL)
+               | occludedFill(rookMovers, empty, -8, ~0ULL)
+               | occludedFill(rookMovers, empty, 1, NotFileA)
+               | occludedFill(rookMovers, empty, -1, NotFileH);
+    maps.bishops = occludedFill(bishopMovers, empty, 9, NotFileA)
+                 | occludedFill(bishopMovers, empty, 7, NotFileH)
+                 | occludedFill(bishopMovers, empty, -7, NotFileA)
+                 | occludedFill(bishopMovers, empty, -9, NotFileH);
+    return maps;
+}
+
+#ifdef FILL_HAVE_AVX2
+FILL_TARGET_AVX2 SliderAttackMaps sliderAttackMapsAvx2(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied)
+{
+    // lanes are north, east, north east and north west in up, the mirror
+    // directions (south, west, south west, south east) in down, same shifts
+    const __m256i shifts = _mm256_setr_epi64x(8, 1, 9, 7);
+    const __m256i shifts2 = _mm256_slli_epi64(shifts, 1);
+    const __m256i shifts4 = _mm256_slli_epi64(shifts, 2);
+    const __m256i upMasks = _mm256_setr_epi64x(~0LL, (long long)NotFileA, (long long)NotFileA, (long long)NotFileH);
+    const __m256i downMasks = _mm256_setr_epi64x(~0LL, (long long)NotFileH, (long long)NotFileH, (long long)NotFileA);
+
+    __m256i empty = _mm256_set1_epi64x((long long)~occupied);
+    __m256i up = _mm256_setr_epi64x((long long)rookMovers, (long long)rookMovers, (long long)bishopMovers, (long long)bishopMovers);
+    __m256i down = up;
+    __m256i upEmpty = _mm256_and_si256(empty, upMasks);
+    __m256i downEmpty = _mm256_and_si256(empty, downMasks);
+
+    // the same 1, 2, 4 step fill as occludedFill, both halves interleaved
+    up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shifts)));
+    down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shifts)));
+    upEmpty = _mm256_and_si256(upEmpty, _mm256_sllv_epi64(upEmpty, shifts));
+    downEmpty = _mm256_and_si256(downEmpty, _mm256_srlv_epi64(downEmpty, shifts));
+    up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shifts2)));
+    down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shifts2)));
+    upEmpty = _mm256_and_si256(upEmpty, _mm256_sllv_epi64(upEmpty, shifts2));
+    downEmpty = _mm256_and_si256(downEmpty, _mm256_srlv_epi64(downEmpty, shifts2));
+    up = _mm256_or_si256(up, _mm256_and_si256(upEmpty, _mm256_sllv_epi64(up, shifts4)));
+    down = _mm256_or_si256(down, _mm256_and_si256(downEmpty, _mm256_srlv_epi64(down, shifts4)));
+
+    __m256i attacks = _mm256_or_si256(_mm256_and_si256(_mm256_sllv_epi64(up, shifts), upMasks),
+                                      _mm256_and_si256(_mm256_srlv_epi64(down, shifts), downMasks));
+    // rook lanes in the low half, bishop lanes in the high one
+    __m128i rooks = _mm256_castsi256_si128(attacks);
+    __m128i bishops = _mm256_extracti128_si256(attacks, 1);
+    rooks = _mm_or_si128(rooks, _mm_unpackhi_epi64(rooks, rooks));
+    bishops = _mm_or_si128(bishops, _mm_unpackhi_epi64(bishops, bishops));
+    return { (uint64_t)_mm_cvtsi128_si64(rooks), (uint64_t)_mm_cvtsi128_si64(bishops) };
+}
+#else
+SliderAttackMaps sliderAttackMapsAvx2(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied)
+{
+    return sliderAttackMapsScalar(rookMovers, bishopMovers, occupied);
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// set-wise slider attacks by Kogge-Stone occluded fill: every rook mover (rooks and
+// queens) and every bishop mover of a bitboard is flooded along its rays at once,
+// three shift-and-mask steps per direction, no table lookups. for eval terms that
+// want a whole side's attack map (king safety, threats) rather than one square's.
+// the AVX2 version runs four directions per vector, two vectors cover all eight
+//
+enum FillBackend { FILL_SCALAR, FILL_AVX2 };
+
+// picked at startup from what the CPU has, a tool may override it before use
+extern FillBackend SliderFill;
+
+const char* fillBackendName(FillBackend backend);
+// AVX2 is there and the OS saves the ymm registers
+bool cpuHasAvx2();
+inline FillBackend bestFillBackend() { return cpuHasAvx2() ? FILL_AVX2 : FILL_SCALAR; }
+
+struct SliderAttackMaps
+{
+    uint64_t rooks;   // squares attacked along ranks and files by rookMovers
+    uint64_t bishops; // squares attacked along diagonals by bishopMovers
+};
+
+SliderAttackMaps sliderAttackMapsScalar(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied);
+// only call where cpuHasAvx2()
+SliderAttackMaps sliderAttackMapsAvx2(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied);
+
+inline SliderAttackMaps sliderAttackMaps(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied)
+{
+    return SliderFill == FILL_AVX2 ? sliderAttackMapsAvx2(rookMovers, bishopMovers, occupied)
+                                   : sliderAttackMapsScalar(rookMovers, bishopMovers, occupied);
+}
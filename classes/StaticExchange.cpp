@@ -0,0 +1,153 @@
+#include "StaticExchange.h"
+#include "Evaluate.h"
+#include "MagicBitboards.h"
+#include <algorithm>
+
+// what one exchange on a square starts from: the material the first capture
+// wins and the value of the piece left standing there
+struct ExchangeStart
+{
+    int gain;
+    int attackerValue;
+    uint64_t occupancy;
+};
+
+static ExchangeStart exchangeStart(const Position& position, const BitMove& move)
+{
+    ExchangeStart start;
+    int target = position.pieceAt(move.to());
+    start.gain = target == EMPTY_SQUARES ? 0 : PieceValues[pieceTypeOf(target)];
+    start.attackerValue = PieceValues[pieceTypeOf(position.pieceAt(move.from()))];
+    start.occupancy = position.occupancy() & ~(1ULL << move.from());
+    if (move.isEnPassant()) {
+        // the captured pawn isn't on the target square, and stops blocking whatever it was
+        start.gain = PieceValues[Pawn];
+        start.occupancy &= ~(1ULL << (move.to() - 8 * position.sideToMove()));
+    }
+    if (move.isPromotion()) {
+        // the piece standing on the square afterwards is the promoted one
+        start.gain += PieceValues[move.promotionPiece()] - PieceValues[Pawn];
+        start.attackerValue = PieceValues[move.promotionPiece()];
+    }
+    return start;
+}
+
+static uint64_t sidePieces(const Position& position, int side)
+{
+    return position.pieces(side == WHITE ? WHITE_ALL_PIECEES : BLACK_ALL_PIECES);
+}
+
+// side's least valuable piece among attackers, 0 if it has none
+static uint64_t leastValuableAttacker(const Position& position, uint64_t attackers, int side, int& type)
+{
+    for (type = Pawn; type <= King; type++) {
+        uint64_t candidates = attackers & position.pieces(pieceIndexFor((ChessPiece)type, side));
+        if (candidates) {
+            return candidates & (0 - candidates);
+        }
+    }
+    return 0;
+}
+
+// a capturer has left square's lines: whatever slid up behind it attacks now too
+static uint64_t addXrays(const Position& position, int square, uint64_t attackers, uint64_t occupancy)
+{
+    uint64_t queens = position.pieces(WHITE_QUEENS) | position.pieces(BLACK_QUEENS);
+    uint64_t bishopsQueens = position.pieces(WHITE_BISHOPS) | position.pieces(BLACK_BISHOPS) | queens;
+    uint64_t rooksQueens = position.pieces(WHITE_ROOKS) | position.pieces(BLACK_ROOKS) | queens;
+    attackers |= (getBishopAttacks(square, occupancy) & bishopsQueens) | (getRookAttacks(square, occupancy) & rooksQueens);
+    return attackers & occupancy;
+}
+
+int see(const Position& position, const BitMove& move)
+{
+    if (move.isCastle()) {
+        return 0;
+    }
+    int gain[32];
+    int depth = 0;
+    int square = move.to();
+    ExchangeStart start = exchangeStart(position, move);
+    uint64_t occupancy = start.occupancy;
+    uint64_t attackers = position.attackersTo(square, occupancy) & occupancy;
+    uint64_t fromBit = 1ULL << move.from();
+    int attackerValue = start.attackerValue;
+    int side = position.sideToMove();
+
+    gain[0] = start.gain;
+    do {
+        depth++;
+        // what the last capturer gains if it gets taken back. no cutting this short
+        // once the sign is settled, callers want the value, seeGE is the quick test
+        gain[depth] = attackerValue - gain[depth - 1];
+        occupancy &= ~fromBit;
+        attackers = addXrays(position, square, attackers, occupancy);
+        side = -side;
+
+        int type;
+        fromBit = leastValuableAttacker(position, attackers, side, type);
+        // taking with the king into a defended square isn't a capture at all
+        if (type == King && (attackers & sidePieces(position, -side))) {
+            fromBit = 0;
+        }
+        if (fromBit) {
+            attackerValue = PieceValues[type];
+        }
+    } while (fromBit && depth < 31);
+
+    while (--depth) {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+    return gain[0];
+}
+
+bool seeGE(const Position& position, const BitMove& move, int threshold)
+{
+    if (move.isCastle()) {
+        return threshold <= 0;
+    }
+    int square = move.to();
+    ExchangeStart start = exchangeStart(position, move);
+
+    // balance is the result so far, for the side that made the move, assuming
+    // the piece now on the square is lost. even keeping it for free isn't enough
+    int balance = start.gain - threshold;
+    if (balance < 0) {
+        return false;
+    }
+    // losing it is still enough
+    balance -= start.attackerValue;
+    if (balance >= 0) {
+        return true;
+    }
+
+    uint64_t occupancy = start.occupancy;
+    uint64_t attackers = position.attackersTo(square, occupancy) & occupancy;
+    int side = position.sideToMove();
+    // the side that is ahead when the recaptures run out
+    int winner = side;
+    while (true) {
+        side = -side;
+        int type;
+        uint64_t fromBit = leastValuableAttacker(position, attackers, side, type);
+        if (!fromBit) {
+            break;
+        }
+        // the king can only take last, and only if nothing takes it back
+        if (type == King) {
+            if (!(attackers & sidePieces(position, -side))) {
+                winner = side;
+            }
+            break;
+        }
+        winner = side;
+        // flip to side's point of view, it now stands to lose the capturer
+        balance = -balance - 1 - PieceValues[type];
+        if (balance >= 0) {
+            break;
+        }
+        occupancy &= ~fromBit;
+        attackers = addXrays(position, square, attackers, occupancy);
+    }
+    return winner == position.sideToMove();
+}
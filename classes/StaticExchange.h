@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Position.h"
+
+// static exchange evaluation: the material balance (in evaluation units, from the
+// mover's point of view) of the capture sequence move starts on its target square,
+// both sides always recapturing with their least valuable attacker. sliders lined
+// up behind a capturer (x-rays) join in once it has gone, the king only recaptures
+// when nothing can take it back. pins are ignored
+int see(const Position& position, const BitMove& move);
+
+// see(position, move) >= threshold, without working out the whole sequence: it
+// stops as soon as the side to recapture can't change the answer
+bool seeGE(const Position& position, const BitMove& move, int threshold);
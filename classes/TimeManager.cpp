@@ -0,0 +1,74 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+// time kept back for move application/drawing so we never flag on overhead
+constexpr int64_t MoveOverheadMs = 30;
+constexpr int64_t MinimumThinkMs = 10;
+constexpr int DefaultMovesToGo = 40;
+
+// soft deadline multiplier by the number of iterations the best move has survived
+static const double StabilityScale[] = { 1.6, 1.25, 1.0, 0.85, 0.7 };
+
+TimeManager::TimeManager()
+{
+    _softMs = 0;
+    _hardMs = 0;
+    _stabilityScale = 1.0;
+    _stableIterations = 0;
+    _iterations = 0;
+}
+
+void TimeManager::start(const SearchLimits& limits)
+{
+    restart();
+    _stabilityScale = 1.0;
+    _stableIterations = 0;
+    _iterations = 0;
+    _lastBestMove = BitMove::none();
+
+    if (limits.moveTimeMs > 0) {
+        _softMs = _hardMs = std::max<int64_t>(limits.moveTimeMs - MoveOverheadMs, MinimumThinkMs);
+        return;
+    }
+    if (limits.timeLeftMs <= 0) {
+        _softMs = _hardMs = 0;
+        return;
+    }
+
+    int64_t available = std::max<int64_t>(limits.timeLeftMs - MoveOverheadMs, MinimumThinkMs);
+    int movesToGo = limits.movesToGo > 0 ? std::min(limits.movesToGo, 50) : DefaultMovesToGo;
+    int64_t target = available / movesToGo + limits.incrementMs * 3 / 4;
+
+    _softMs = std::clamp<int64_t>(target, MinimumThinkMs, available);
+    // never burn more than a fifth of what's left (or all of it with one move to go)
+    int64_t ceiling = movesToGo == 1 ? available : available / 5 + limits.incrementMs;
+    _hardMs = std::clamp<int64_t>(target * 4, _softMs, std::max(ceiling, _softMs));
+}
+
+void TimeManager::iterationFinished(BitMove bestMove)
+{
+    if (_iterations > 0 && bestMove == _lastBestMove) {
+        _stableIterations++;
+    } else {
+        _stableIterations = 0;
+    }
+    _iterations++;
+    _lastBestMove = bestMove;
+    _stabilityScale = StabilityScale[std::min(_stableIterations, 4)];
+}
+
+int64_t TimeManager::elapsedMs() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _startTime.load(std::memory_order_relaxed)).count();
+}
+
+bool TimeManager::softExpired() const
+{
+    // the next iteration costs a multiple of this one, don't start it past ~60% of the budget
+    return isTimed() && elapsedMs() >= std::min<int64_t>(softLimitMs() * 6 / 10, _hardMs);
+}
+
+bool TimeManager::hardExpired() const
+{
+    return isTimed() && elapsedMs() >= _hardMs;
+}
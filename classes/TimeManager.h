@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "BitBoard.h"
+
+// what the search was asked to do, all times in milliseconds (0 = not set)
+struct SearchLimits
+{
+    int timeLeftMs = 0;
+    int incrementMs = 0;
+    int movesToGo = 0;
+    int moveTimeMs = 0;
+    int minDepth = 1; // no stopping at the soft deadline before this depth (the hard one always stops)
+    int maxDepth = 0;
+};
+
+//
+// turns the clock into two deadlines for iterative deepening:
+// the soft one decides whether another iteration is started, the hard one
+// aborts the search mid iteration. the soft deadline is stretched while the
+// best move keeps changing between iterations and shrunk once it settles.
+//
+class TimeManager
+{
+public:
+    TimeManager();
+
+    void start(const SearchLimits& limits);
+    // starts the clock again without touching the deadlines (a ponder hit), safe to call mid search
+    void restart() { _startTime.store(std::chrono::steady_clock::now(), std::memory_order_relaxed); }
+    // report the best move of each finished iteration
+    void iterationFinished(BitMove bestMove);
+
+    bool isTimed() const { return _hardMs > 0; }
+    bool softExpired() const;
+    bool hardExpired() const;
+    int64_t elapsedMs() const;
+    int64_t softLimitMs() const { return (int64_t)(_softMs * _stabilityScale); }
+    int64_t hardLimitMs() const { return _hardMs; }
+
+private:
+    std::atomic<std::chrono::steady_clock::time_point> _startTime;
+    int64_t _softMs;
+    int64_t _hardMs;
+    double _stabilityScale;
+    int _stableIterations;
+    int _iterations;
+    BitMove _lastBestMove;
+};
@@ -0,0 +1,139 @@
+#include "TranspositionTable.h"
+#include <algorithm>
+#include <cstring>
+
+TranspositionTable::TranspositionTable()
+{
+    _buckets = nullptr;
+    _bucketCount = 0;
+    _megabytes = 0;
+    _generation = 0;
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    delete[] _buckets;
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    if (megabytes == 0) {
+        megabytes = 1;
+    }
+    if (_buckets && megabytes == _megabytes) {
+        return;
+    }
+    // round down to a power of two number of buckets so indexing is a mask
+    size_t count = 1;
+    while (count * 2 * sizeof(TTBucket) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    delete[] _buckets;
+    _buckets = new TTBucket[count];
+    _bucketCount = count;
+    _megabytes = megabytes;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    if (_buckets) {
+        std::memset(static_cast<void*>(_buckets), 0, _bucketCount * sizeof(TTBucket));
+    }
+    _generation = 0;
+}
+
+// move (16 bits) | score (16) | depth (8) | genBound (8) | key check (16)
+uint64_t TranspositionTable::pack(uint16_t check, const TTEntry& entry)
+{
+    return (uint64_t)entry.move.raw()
+         | (uint64_t)(uint16_t)entry.score << 16
+         | (uint64_t)(uint8_t)entry.depth << 32
+         | (uint64_t)entry.genBound << 40
+         | (uint64_t)check << 48;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data)
+{
+    TTEntry entry;
+    entry.move = BitMove::fromRaw((uint16_t)data);
+    entry.score = (int16_t)(uint16_t)(data >> 16);
+    entry.depth = (int8_t)(uint8_t)(data >> 32);
+    entry.genBound = (uint8_t)(data >> 40);
+    return entry;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const
+{
+    TTBucket& bucket = bucketFor(key);
+    uint16_t check = keyCheck(key);
+    for (int i = 0; i < TTBucketSize; i++) {
+        uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        if ((uint16_t)(data >> 48) == check) {
+            entry = unpack(data);
+            return entry.bound() != BOUND_NONE;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, TTBound bound, int score, BitMove move)
+{
+    // scores that don't fit in the entry (the "no moves" sentinels) aren't worth keeping
+    if (score <= INT16_MIN || score >= INT16_MAX) {
+        return;
+    }
+
+    TTBucket& bucket = bucketFor(key);
+    uint16_t check = keyCheck(key);
+    TTSlot* replace = &bucket.slots[0];
+    TTEntry old = unpack(replace->data.load(std::memory_order_relaxed));
+    bool sameKey = false;
+    int replaceWorth = INT32_MAX;
+    for (int i = 0; i < TTBucketSize; i++) {
+        TTSlot& slot = bucket.slots[i];
+        uint64_t data = slot.data.load(std::memory_order_relaxed);
+        TTEntry entry = unpack(data);
+        sameKey = (uint16_t)(data >> 48) == check;
+        if (sameKey || entry.bound() == BOUND_NONE) {
+            replace = &slot;
+            old = entry;
+            break;
+        }
+        // prefer overwriting stale entries, then shallow ones
+        int age = (_generation - entry.generation()) & 63;
+        int worth = entry.depth - 8 * age;
+        if (worth < replaceWorth) {
+            replaceWorth = worth;
+            replace = &slot;
+            old = entry;
+        }
+    }
+
+    TTEntry entry;
+    // keep the old best move if this result didn't produce one
+    entry.move = (move.isNone() && sameKey) ? old.move : move;
+    entry.score = (int16_t)score;
+    // timed searches may iterate past what an int8 holds, deeper still counts as deepest
+    entry.depth = (int8_t)std::min(depth, 127);
+    entry.genBound = (uint8_t)((_generation << 2) | bound);
+    replace->data.store(pack(check, entry), std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const
+{
+    if (!_buckets) {
+        return 0;
+    }
+    size_t samples = _bucketCount < 1000 ? _bucketCount : 1000;
+    int used = 0;
+    for (size_t i = 0; i < samples; i++) {
+        for (int j = 0; j < TTBucketSize; j++) {
+            TTEntry entry = unpack(_buckets[i].slots[j].data.load(std::memory_order_relaxed));
+            if (entry.bound() != BOUND_NONE && entry.generation() == _generation) {
+                used++;
+            }
+        }
+    }
+    return (int)(used * 1000 / (samples * TTBucketSize));
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "BitBoard.h"
+
+enum TTBound : uint8_t
+{
+    BOUND_NONE,
+    BOUND_UPPER, // failed low, score is at most this
+    BOUND_LOWER, // failed high, score is at least this
+    BOUND_EXACT
+};
+
+// what a probe hands back, unpacked from a slot
+struct TTEntry
+{
+    BitMove move;
+    int16_t score;
+    int8_t depth;
+    uint8_t genBound; // generation in the top 6 bits, TTBound in the low 2
+
+    TTBound bound() const { return (TTBound)(genBound & 3); }
+    uint8_t generation() const { return genBound >> 2; }
+};
+
+//
+// one table slot: the top 16 bits of the key and the entry packed into a single
+// 64 bit word. every search thread reads and writes slots without locking, one
+// word can't be torn, and the bucket index supplies the key's low bits.
+//
+struct TTSlot
+{
+    std::atomic<uint64_t> data;
+};
+
+constexpr int TTBucketSize = 8;
+
+struct alignas(64) TTBucket
+{
+    TTSlot slots[TTBucketSize];
+};
+
+static_assert(sizeof(TTSlot) == 8, "TTSlot should stay 8 bytes");
+static_assert(sizeof(TTBucket) == 64, "TTBucket should fill one cache line");
+
+//
+// fixed size, bucketed hash table of search results keyed by the position's
+// Zobrist key, shared by all search threads. entries from older searches
+// (generations) are replaced first, then the shallowest one in the bucket.
+//
+class TranspositionTable
+{
+public:
+    TranspositionTable();
+    ~TranspositionTable();
+
+    void resize(size_t megabytes);
+    void clear();
+    // call once per search so entries from earlier searches age out
+    void newSearch() { _generation = (_generation + 1) & 63; }
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, int depth, TTBound bound, int score, BitMove move);
+
+    // how full the table is in permille, sampled from the first 1000 buckets
+    int hashfull() const;
+    size_t sizeMB() const { return _megabytes; }
+
+private:
+    TTBucket& bucketFor(uint64_t key) const { return _buckets[key & (_bucketCount - 1)]; }
+    static uint16_t keyCheck(uint64_t key) { return (uint16_t)(key >> 48); }
+    static uint64_t pack(uint16_t check, const TTEntry& entry);
+    static TTEntry unpack(uint64_t data);
+
+    TTBucket* _buckets;
+    size_t _bucketCount;
+    size_t _megabytes;
+    uint8_t _generation;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+//
+// Zobrist hashing keys, generated at compile time from a fixed seed so
+// hashes are identical from run to run (and between threads/processes).
+// one key per (piece index, square), one for black to move, one per set of
+// castling rights and one per en passant file
+//
+struct ZobristKeys
+{
+    uint64_t pieceSquare[12][64];
+    uint64_t blackToMove;
+    uint64_t castling[16];
+    uint64_t enPassantFile[8];
+};
+
+constexpr uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys{};
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            keys.pieceSquare[piece][square] = splitMix64(seed);
+        }
+    }
+    keys.blackToMove = splitMix64(seed);
+    // no rights at all hashes to nothing, like a position that never had any
+    for (int rights = 1; rights < 16; rights++) {
+        keys.castling[rights] = splitMix64(seed);
+    }
+    for (int file = 0; file < 8; file++) {
+        keys.enPassantFile[file] = splitMix64(seed);
+    }
+    return keys;
+}
+
+inline constexpr ZobristKeys Zobrist = makeZobristKeys();
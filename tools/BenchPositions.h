@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// the positions bench and pruning search, so their numbers describe the same work
+inline const std::vector<std::string> BenchPositions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w",
+    "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w",
+    "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PB2BPPP/2RQ1RK1 w",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w",
+};
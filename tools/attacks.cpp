@@ -0,0 +1,118 @@
+//
+// whole-board slider attack maps, no GUI
+//
+//   attacks [iterations]
+//
+// checks that the Kogge-Stone fills (scalar and, where the CPU has it, AVX2) give
+// the same attack maps as a magic lookup per slider, over a set of positions and
+// random boards, then times all of them building both sides' rook and bishop maps.
+// exits non-zero on any mismatch, it's what ctest runs.
+//
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../classes/MagicBitboards.h"
+#include "../classes/Position.h"
+#include "../classes/SliderFill.h"
+
+static const std::vector<std::string> Positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PB2BPPP/2RQ1RK1 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+// one side's sliders on a board
+struct Sliders
+{
+    uint64_t rookMovers;
+    uint64_t bishopMovers;
+    uint64_t occupied;
+};
+
+static SliderAttackMaps magicAttackMaps(uint64_t rookMovers, uint64_t bishopMovers, uint64_t occupied)
+{
+    SliderAttackMaps maps = { 0, 0 };
+    for (uint64_t pieces = rookMovers; pieces; pieces &= pieces - 1) {
+        maps.rooks |= getRookAttacks(getFirstBit(pieces), occupied);
+    }
+    for (uint64_t pieces = bishopMovers; pieces; pieces &= pieces - 1) {
+        maps.bishops |= getBishopAttacks(getFirstBit(pieces), occupied);
+    }
+    return maps;
+}
+
+static std::vector<Sliders> testBoards()
+{
+    std::vector<Sliders> boards;
+    Position position;
+    for (const std::string& fen : Positions) {
+        position.setFromFEN(fen);
+        boards.push_back({ position.pieces(WHITE_ROOKS) | position.pieces(WHITE_QUEENS),
+                           position.pieces(WHITE_BISHOPS) | position.pieces(WHITE_QUEENS), position.occupancy() });
+        boards.push_back({ position.pieces(BLACK_ROOKS) | position.pieces(BLACK_QUEENS),
+                           position.pieces(BLACK_BISHOPS) | position.pieces(BLACK_QUEENS), position.occupancy() });
+    }
+    // random boards reach the edges and wrap cases the real ones don't
+    std::mt19937_64 random(0xF111);
+    for (int i = 0; i < 10000; i++) {
+        uint64_t occupied = random() & random();
+        uint64_t movers = occupied & random() & random();
+        boards.push_back({ movers & random(), movers & random(), occupied });
+    }
+    return boards;
+}
+
+template <typename MapsFunction>
+static double timeMaps(const std::vector<Sliders>& boards, int iterations, MapsFunction maps, uint64_t& checksum)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        for (const Sliders& board : boards) {
+            SliderAttackMaps result = maps(board.rookMovers, board.bishopMovers, board.occupied);
+            checksum += result.rooks ^ result.bishops;
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / ((double)iterations * boards.size());
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 100;
+    initMagicBitboards();
+    bool avx2 = cpuHasAvx2();
+    std::cout << "sliders " << sliderBackendName(SliderIndexing) << ", fill " << fillBackendName(SliderFill) << "\n";
+
+    std::vector<Sliders> boards = testBoards();
+    int failures = 0;
+    for (const Sliders& board : boards) {
+        SliderAttackMaps expected = magicAttackMaps(board.rookMovers, board.bishopMovers, board.occupied);
+        SliderAttackMaps scalar = sliderAttackMapsScalar(board.rookMovers, board.bishopMovers, board.occupied);
+        SliderAttackMaps vector = avx2 ? sliderAttackMapsAvx2(board.rookMovers, board.bishopMovers, board.occupied) : expected;
+        if (scalar.rooks != expected.rooks || scalar.bishops != expected.bishops
+            || vector.rooks != expected.rooks || vector.bishops != expected.bishops) {
+            failures++;
+        }
+    }
+    std::cout << boards.size() << " boards, " << failures << " failed\n";
+
+    uint64_t checksum = 0;
+    std::cout << std::fixed << std::setprecision(2)
+              << std::setw(10) << "magic" << std::setw(10) << timeMaps(boards, iterations, magicAttackMaps, checksum) << " ns/side\n"
+              << std::setw(10) << "scalar" << std::setw(10) << timeMaps(boards, iterations, sliderAttackMapsScalar, checksum) << " ns/side\n";
+    if (avx2) {
+        std::cout << std::setw(10) << "avx2" << std::setw(10) << timeMaps(boards, iterations, sliderAttackMapsAvx2, checksum) << " ns/side\n";
+    }
+    // keeps the work from being optimized away
+    std::cout << "checksum " << std::hex << checksum << std::dec << "\n";
+    return failures ? 1 : 0;
+}
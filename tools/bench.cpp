@@ -0,0 +1,118 @@
+//
+// search benchmark, no GUI
+//
+//   bench [--magic] [depth] [maxThreads]
+//
+// searches a fixed set of positions to a fixed depth with 1, 2, 4, 8 and 16
+// threads and reports time to depth and the speedup over one thread, plus the
+// share of beta cutoffs that came from the first move searched (fmc), the heap
+// allocations made inside think() (allocs) and the pawn evaluation cache hit
+// rate (pawn). --magic forces magic multiply slider indexing where PEXT would
+// be picked.
+//
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../classes/MagicBitboards.h"
+#include "../classes/Position.h"
+#include "../classes/Search.h"
+#include "BenchPositions.h"
+
+// debug allocation counter: every operator new in the process goes through here.
+// the search itself should allocate nothing, only the helper threads it starts
+static std::atomic<uint64_t> Allocations{0};
+
+void* operator new(std::size_t size)
+{
+    Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+// rough rule of thumb at these depths: each doubling of search speed is worth ~70 Elo
+constexpr double EloPerDoubling = 70.0;
+
+int main(int argc, char** argv)
+{
+    SliderBackend backend = bestSliderBackend();
+    if (argc > 1 && std::string(argv[1]) == "--magic") {
+        backend = SLIDERS_MAGIC;
+        argc--;
+        argv++;
+    }
+    int depth = argc > 1 ? std::atoi(argv[1]) : 6;
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : 16;
+
+    initMagicBitboards(backend);
+
+    Search search;
+    search.resizeHash(64);
+
+    std::cout << "depth " << depth << ", " << BenchPositions.size() << " positions, sliders " << sliderBackendName(backend) << "\n";
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "time ms" << std::setw(14) << "nodes"
+              << std::setw(12) << "nps" << std::setw(10) << "speedup" << std::setw(12) << "efficiency"
+              << std::setw(10) << "~elo" << std::setw(8) << "fmc" << std::setw(8) << "allocs" << std::setw(8) << "pawn" << "\n";
+
+    double singleThreadMs = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        search.setThreads(threads);
+        int64_t totalMs = 0;
+        uint64_t totalNodes = 0;
+        uint64_t betaCutoffs = 0;
+        uint64_t firstMoveCutoffs = 0;
+        uint64_t allocations = 0;
+        uint64_t pawnProbes = 0;
+        uint64_t pawnHits = 0;
+        for (const std::string& fen : BenchPositions) {
+            Position position;
+            position.setFromFEN(fen);
+            search.newGame();
+
+            SearchLimits limits;
+            limits.maxDepth = depth;
+            uint64_t allocationsBefore = Allocations.load(std::memory_order_relaxed);
+            SearchResult result = search.think(position, limits);
+            allocations += Allocations.load(std::memory_order_relaxed) - allocationsBefore;
+            totalMs += result.timeMs;
+            totalNodes += result.nodes;
+            betaCutoffs += result.betaCutoffs;
+            firstMoveCutoffs += result.firstMoveCutoffs;
+            pawnProbes += result.pawnProbes;
+            pawnHits += result.pawnHits;
+        }
+
+        double ms = std::max<double>((double)totalMs, 1.0);
+        if (threads == 1) {
+            singleThreadMs = ms;
+        }
+        double speedup = singleThreadMs / ms;
+        std::cout << std::setw(8) << threads << std::setw(12) << totalMs << std::setw(14) << totalNodes
+                  << std::setw(12) << (uint64_t)(totalNodes * 1000 / ms)
+                  << std::setw(10) << std::fixed << std::setprecision(2) << speedup
+                  << std::setw(11) << std::setprecision(0) << speedup / threads * 100 << "%"
+                  << std::setw(10) << std::showpos << EloPerDoubling * std::log2(speedup) << std::noshowpos
+                  << std::setw(7) << std::setprecision(1)
+                  << (betaCutoffs ? 100.0 * firstMoveCutoffs / betaCutoffs : 0.0) << "%"
+                  << std::setw(8) << allocations
+                  << std::setw(7) << (pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0) << "%\n";
+    }
+
+    return 0;
+}
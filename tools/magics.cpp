@@ -0,0 +1,353 @@
+//
+// offline magic number finder, no GUI
+//
+//   magics [--fixed] [candidates] [header]
+//
+// searches "black" magics for every rook and bishop square: the index is
+// ((occupied | ~mask) * magic) >> shift, which lets a square's entries cluster
+// in a narrow span of the index range and leave holes. squares are packed into
+// one shared table, each at the first offset where its entries only land on free
+// slots or on slots already holding the same attack set, so tables overlap. of
+// candidates working magics per square the few with the narrowest spans are
+// tried for packing and the one that ends the table earliest is kept. --fixed
+// uses one shift per piece type (12 bits for rooks, 9 for bishops) instead of
+// the smallest shift per square, so lookups need no shift table.
+//
+// the packed slots then hold 16 bit ids into the few thousand distinct attack
+// sets instead of the sets themselves. prints table size and lookup speed of
+// both forms against the magics in MagicBitboards.h, and writes the shared form
+// to header (SliderTables.h by default) as constexpr arrays, so a build that
+// uses it has nothing to compute at startup.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../classes/MagicBitboards.h"
+
+constexpr uint64_t Unused = ~0ULL; // no attack set is ever every square
+
+// narrowest-span candidates per square that get a packing attempt
+constexpr int PackCandidates = 8;
+
+struct FoundMagic
+{
+    uint64_t magic;
+    int shift;
+    int32_t offset; // may be negative, the square's lowest index is never below -offset
+};
+
+// every occupancy of a square's mask with the attacks it gives
+struct SquareSubsets
+{
+    std::vector<uint64_t> occupancies;
+    std::vector<uint64_t> attacks;
+};
+
+static SquareSubsets subsetsFor(int square, const uint64_t* masks, uint64_t (*attacks)(int, uint64_t))
+{
+    SquareSubsets subsets;
+    uint64_t mask = masks[square];
+    int bits = countOnes(mask);
+    for (int i = 0; i < (1 << bits); i++) {
+        uint64_t occupancy = indexToUint64(i, bits, mask);
+        subsets.occupancies.push_back(occupancy);
+        subsets.attacks.push_back(attacks(square, occupancy));
+    }
+    return subsets;
+}
+
+static inline uint64_t blackIndex(uint64_t occupied, uint64_t mask, uint64_t magic, int shift)
+{
+    return ((occupied | ~mask) * magic) >> shift;
+}
+
+// a square's table while a candidate is tried. most candidates fail after a few
+// occupancies, so slots are stamped with the try they belong to instead of cleared
+struct Scratch
+{
+    explicit Scratch(size_t size) : attacks(size), stamps(size, 0), stamp(0) {}
+
+    std::vector<uint64_t> attacks;
+    std::vector<uint32_t> stamps;
+    uint32_t stamp;
+};
+
+// the square's table for magic as (index, attacks) pairs, false if two occupancies
+// with different attacks collide
+static bool fillTable(const SquareSubsets& subsets, uint64_t mask, uint64_t magic, int shift,
+                      Scratch& scratch, std::vector<std::pair<uint32_t, uint64_t>>& entries)
+{
+    scratch.stamp++;
+    entries.clear();
+    for (size_t i = 0; i < subsets.occupancies.size(); i++) {
+        uint64_t index = blackIndex(subsets.occupancies[i], mask, magic, shift);
+        if (scratch.stamps[index] != scratch.stamp) {
+            scratch.stamps[index] = scratch.stamp;
+            scratch.attacks[index] = subsets.attacks[i];
+            entries.push_back({ (uint32_t)index, subsets.attacks[i] });
+        } else if (scratch.attacks[index] != subsets.attacks[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void indexSpan(const std::vector<std::pair<uint32_t, uint64_t>>& entries, uint32_t& lowest, uint32_t& highest)
+{
+    lowest = ~0u;
+    highest = 0;
+    for (const auto& entry : entries) {
+        lowest = std::min(lowest, entry.first);
+        highest = std::max(highest, entry.first);
+    }
+}
+
+// first offset at which entries fit into table, next to or on top of what's there
+static int32_t firstFit(const std::vector<uint64_t>& table, const std::vector<std::pair<uint32_t, uint64_t>>& entries)
+{
+    uint32_t lowest, highest;
+    indexSpan(entries, lowest, highest);
+    for (int32_t offset = -(int32_t)lowest;; offset++) {
+        bool fits = true;
+        for (const auto& [index, attacks] : entries) {
+            size_t slot = offset + index;
+            if (slot < table.size() && table[slot] != Unused && table[slot] != attacks) {
+                fits = false;
+                break;
+            }
+        }
+        if (fits) {
+            return offset;
+        }
+    }
+}
+
+static void place(std::vector<uint64_t>& table, int32_t offset, const std::vector<std::pair<uint32_t, uint64_t>>& entries)
+{
+    for (const auto& [index, attacks] : entries) {
+        size_t slot = offset + index;
+        if (slot >= table.size()) {
+            table.resize(slot + 1, Unused);
+        }
+        table[slot] = attacks;
+    }
+}
+
+// finds magics for one piece type and packs their tables into table
+static void findMagics(std::vector<uint64_t>& table, FoundMagic* found, const uint64_t* masks,
+                       uint64_t (*attacks)(int, uint64_t), int fixedBits, int candidates, std::mt19937_64& random)
+{
+    // biggest tables first, the small ones fill the holes they leave
+    int order[64];
+    for (int square = 0; square < 64; square++) {
+        order[square] = square;
+    }
+    std::stable_sort(order, order + 64, [&](int a, int b) { return countOnes(masks[a]) > countOnes(masks[b]); });
+
+    std::vector<std::pair<uint32_t, uint64_t>> entries;
+    for (int square : order) {
+        SquareSubsets subsets = subsetsFor(square, masks, attacks);
+        uint64_t mask = masks[square];
+        int bits = fixedBits ? fixedBits : countOnes(mask);
+        int shift = 64 - bits;
+        Scratch scratch((size_t)1 << bits);
+
+        // (span, magic) of the narrowest candidates so far
+        std::vector<std::pair<uint32_t, uint64_t>> narrowest;
+        int tried = 0;
+        while (tried < candidates) {
+            // sparse candidates are far more likely to work
+            uint64_t magic = random() & random() & random();
+            if (countOnes((mask * magic) >> 56) < 6 || !fillTable(subsets, mask, magic, shift, scratch, entries)) {
+                continue;
+            }
+            tried++;
+            uint32_t lowest, highest;
+            indexSpan(entries, lowest, highest);
+            narrowest.push_back({ highest - lowest, magic });
+            std::sort(narrowest.begin(), narrowest.end());
+            if ((int)narrowest.size() > PackCandidates) {
+                narrowest.pop_back();
+            }
+        }
+
+        size_t bestEnd = ~(size_t)0;
+        for (const auto& candidate : narrowest) {
+            fillTable(subsets, mask, candidate.second, shift, scratch, entries);
+            int32_t offset = firstFit(table, entries);
+            uint32_t lowest, highest;
+            indexSpan(entries, lowest, highest);
+            size_t end = std::max(table.size(), (size_t)(offset + (int64_t)highest + 1));
+            if (end < bestEnd) {
+                bestEnd = end;
+                found[square] = { candidate.second, shift, offset };
+            }
+        }
+        fillTable(subsets, mask, found[square].magic, shift, scratch, entries);
+        place(table, found[square].offset, entries);
+    }
+}
+
+// ns per lookup over a fixed sequence of squares and occupancies
+template <typename Lookup>
+static double timeLookups(Lookup lookup, uint64_t& checksum)
+{
+    std::mt19937_64 random(7);
+    std::vector<std::pair<int, uint64_t>> queries(1 << 16);
+    for (auto& query : queries) {
+        query = { (int)(random() & 63), random() & random() };
+    }
+    constexpr int Rounds = 64;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < Rounds; round++) {
+        for (const auto& [square, occupied] : queries) {
+            checksum += lookup(square, occupied);
+        }
+    }
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return ns / (Rounds * (double)queries.size());
+}
+
+// the packed table with every attack set stored once: each slot becomes a 16 bit
+// id into attackSets. there are only a few thousand distinct sets, so slots shrink
+// from 8 bytes to 2 and the whole thing fits in L2
+static void shareSlots(const std::vector<uint64_t>& table, std::vector<uint16_t>& ids, std::vector<uint64_t>& attackSets)
+{
+    std::unordered_map<uint64_t, uint16_t> idOf;
+    attackSets.assign(1, 0); // id 0 for the slots nothing maps to
+    ids.resize(table.size());
+    for (size_t i = 0; i < table.size(); i++) {
+        if (table[i] == Unused) {
+            ids[i] = 0;
+            continue;
+        }
+        auto [it, added] = idOf.emplace(table[i], (uint16_t)attackSets.size());
+        if (added) {
+            attackSets.push_back(table[i]);
+        }
+        ids[i] = it->second;
+    }
+}
+
+static void writeHeader(const std::string& path, const std::vector<uint16_t>& ids, const std::vector<uint64_t>& attackSets,
+                        const FoundMagic* rooks, const FoundMagic* bishops, bool fixed)
+{
+    std::ofstream out(path);
+    out << "#pragma once\n\n"
+        << "// generated by tools/magics.cpp (" << (fixed ? "fixed shift " : "") << "black magics, overlapping tables,\n"
+        << "// shared attack sets), do not edit. attacks for (square, occupied) are\n"
+        << "//   SliderAttackSets[SliderAttackIds[offset + (((occupied | ~mask) * magic) >> shift)]]\n"
+        << "// with mask RMasks/BMasks from MagicBitboards.h and magic, shift and offset from here\n\n"
+        << "#include <cstdint>\n\n"
+        << "struct PackedMagic\n{\n    uint64_t magic;\n    uint32_t shift;\n    int32_t offset;\n};\n\n";
+    auto writeMagics = [&](const char* name, const FoundMagic* magics) {
+        out << "inline constexpr PackedMagic " << name << "[64] = {\n";
+        for (int square = 0; square < 64; square++) {
+            out << "    { 0x" << std::hex << magics[square].magic << std::dec << "ULL, "
+                << magics[square].shift << ", " << magics[square].offset << " },\n";
+        }
+        out << "};\n\n";
+    };
+    writeMagics("RookPackedMagics", rooks);
+    writeMagics("BishopPackedMagics", bishops);
+
+    out << "alignas(64) inline constexpr uint64_t SliderAttackSets[" << attackSets.size() << "] = {\n";
+    for (size_t i = 0; i < attackSets.size(); i++) {
+        out << (i % 4 == 0 ? "    " : " ") << "0x" << std::hex << attackSets[i] << std::dec << "ULL,"
+            << (i % 4 == 3 || i + 1 == attackSets.size() ? "\n" : "");
+    }
+    out << "};\n\n";
+    out << "alignas(64) inline constexpr uint16_t SliderAttackIds[" << ids.size() << "] = {\n";
+    for (size_t i = 0; i < ids.size(); i++) {
+        out << (i % 16 == 0 ? "    " : " ") << ids[i] << "," << (i % 16 == 15 || i + 1 == ids.size() ? "\n" : "");
+    }
+    out << "};\n";
+}
+
+int main(int argc, char** argv)
+{
+    bool fixed = false;
+    if (argc > 1 && std::string(argv[1]) == "--fixed") {
+        fixed = true;
+        argc--;
+        argv++;
+    }
+    int candidates = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 8;
+    std::string header = argc > 2 ? argv[2] : "SliderTables.h";
+
+    // the current tables, for comparison
+    initMagicBitboards(SLIDERS_MAGIC);
+
+    std::mt19937_64 random(0x5EED);
+    std::vector<uint64_t> table;
+    FoundMagic rooks[64];
+    FoundMagic bishops[64];
+    auto start = std::chrono::steady_clock::now();
+    findMagics(table, rooks, RMasks, ratt, fixed ? 12 : 0, candidates, random);
+    findMagics(table, bishops, BMasks, batt, fixed ? 9 : 0, candidates, random);
+    int64_t searchMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint16_t> ids;
+    std::vector<uint64_t> attackSets;
+    shareSlots(table, ids, attackSets);
+
+    // every occupancy has to come back with the right attacks
+    for (int square = 0; square < 64; square++) {
+        for (int rook = 0; rook < 2; rook++) {
+            const FoundMagic& found = rook ? rooks[square] : bishops[square];
+            const uint64_t mask = rook ? RMasks[square] : BMasks[square];
+            SquareSubsets subsets = subsetsFor(square, rook ? RMasks : BMasks, rook ? ratt : batt);
+            for (size_t i = 0; i < subsets.occupancies.size(); i++) {
+                size_t slot = found.offset + blackIndex(subsets.occupancies[i], mask, found.magic, found.shift);
+                if (table[slot] != subsets.attacks[i] || attackSets[ids[slot]] != subsets.attacks[i]) {
+                    std::cerr << "verification failed on square " << square << "\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
+    size_t used = std::count_if(table.begin(), table.end(), [](uint64_t slot) { return slot != Unused; });
+    size_t currentBytes = (RookTableSize + BishopTableSize) * sizeof(uint64_t);
+    size_t packedBytes = table.size() * sizeof(uint64_t);
+    size_t sharedBytes = ids.size() * sizeof(uint16_t) + attackSets.size() * sizeof(uint64_t);
+    std::cout << (fixed ? "fixed shift" : "per square shift") << " black magics, " << candidates
+              << " candidates per square, " << searchMs << " ms\n"
+              << table.size() << " slots (" << used << " used), " << attackSets.size() << " distinct attack sets\n";
+
+    uint64_t checksum = 0;
+    double currentNs = timeLookups([](int square, uint64_t occupied) {
+        return getRookAttacks(square, occupied) ^ getBishopAttacks(square, occupied);
+    }, checksum);
+    double packedNs = timeLookups([&](int square, uint64_t occupied) {
+        const FoundMagic& rook = rooks[square];
+        const FoundMagic& bishop = bishops[square];
+        return table[rook.offset + blackIndex(occupied, RMasks[square], rook.magic, rook.shift)]
+             ^ table[bishop.offset + blackIndex(occupied, BMasks[square], bishop.magic, bishop.shift)];
+    }, checksum);
+    double sharedNs = timeLookups([&](int square, uint64_t occupied) {
+        const FoundMagic& rook = rooks[square];
+        const FoundMagic& bishop = bishops[square];
+        return attackSets[ids[rook.offset + blackIndex(occupied, RMasks[square], rook.magic, rook.shift)]]
+             ^ attackSets[ids[bishop.offset + blackIndex(occupied, BMasks[square], bishop.magic, bishop.shift)]];
+    }, checksum);
+
+    std::cout << std::setw(18) << "" << std::setw(10) << "KB" << std::setw(12) << "ns/lookup" << "\n"
+              << std::fixed << std::setprecision(2)
+              << std::setw(18) << "current" << std::setw(10) << currentBytes / 1024 << std::setw(12) << currentNs << "\n"
+              << std::setw(18) << "packed" << std::setw(10) << packedBytes / 1024 << std::setw(12) << packedNs << "\n"
+              << std::setw(18) << "packed + shared" << std::setw(10) << sharedBytes / 1024 << std::setw(12) << sharedNs << "\n";
+    // keeps the lookups from being optimized away
+    std::cout << "checksum " << std::hex << checksum << std::dec << "\n";
+
+    writeHeader(header, ids, attackSets, rooks, bishops, fixed);
+    std::cout << "wrote " << header << "\n";
+    return 0;
+}
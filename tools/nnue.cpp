@@ -0,0 +1,341 @@
+//
+// NNUE evaluation checks and speed, no GUI
+//
+//   nnue [iterations]
+//   nnue --write <path>
+//
+// there is no trained network yet, so this builds two synthetic ones in the
+// network file format. a random one checks that the incrementally updated
+// accumulators match a full refresh over random walks through the test positions
+// (captures, promotions, castling, en passant, null moves, several plies between
+// evaluations), and that every kernel backend the CPU has gives the same scores.
+// a "material" one, which counts pieces by design, checks the whole pipeline end
+// to end against a plain material count. then it times evaluations in a fixed
+// tree walk: the classical evaluation against the network on each backend.
+// exits non-zero on any mismatch, it's what ctest runs.
+//
+// --write saves the material network, a file to try resources/nn.nnue with.
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../classes/Evaluate.h"
+#include "../classes/MagicBitboards.h"
+#include "../classes/MoveGenerator.h"
+#include "../classes/Nnue.h"
+#include "../classes/PawnTable.h"
+#include "../classes/Position.h"
+
+static const std::vector<std::string> Positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PB2BPPP/2RQ1RK1 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    // no black king: positions set up like this are legal input and evaluate at the leaves
+    "8/5p2/8/3r4/8/2N5/1P3P2/4K3 w - - 0 1",
+};
+
+// a network file in memory, sections where NnueNetwork::layout() puts them
+class NetworkWriter
+{
+public:
+    NetworkWriter(int outputScale) : _layout(NnueNetwork::layout()), _data(_layout.size, 0)
+    {
+        uint32_t header[6] = { 0, NnueNetwork::Version, (uint32_t)NnueInputs, (uint32_t)NnueAccumulatorSize,
+                               (uint32_t)NnueHiddenSize, (uint32_t)outputScale };
+        std::memcpy(header, "NNUE", 4);
+        std::memcpy(_data.data(), header, sizeof(header));
+    }
+
+    int16_t* featureBias() { return section<int16_t>(_layout.featureBias); }
+    int16_t* featureWeights(int feature) { return section<int16_t>(_layout.featureWeights) + (size_t)feature * NnueAccumulatorSize; }
+    int32_t* hidden1Bias() { return section<int32_t>(_layout.hidden1Bias); }
+    int8_t* hidden1Weights(int output) { return section<int8_t>(_layout.hidden1Weights) + output * 2 * NnueAccumulatorSize; }
+    int32_t* hidden2Bias() { return section<int32_t>(_layout.hidden2Bias); }
+    int8_t* hidden2Weights(int output) { return section<int8_t>(_layout.hidden2Weights) + output * NnueHiddenSize; }
+    int32_t* outputBias() { return section<int32_t>(_layout.outputBias); }
+    int8_t* outputWeights() { return section<int8_t>(_layout.outputWeights); }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(_data.data()), (std::streamsize)_data.size());
+        return (bool)file;
+    }
+
+private:
+    template <typename T>
+    T* section(size_t offset) { return reinterpret_cast<T*>(_data.data() + offset); }
+
+    NnueNetwork::Layout _layout;
+    std::vector<uint8_t> _data;
+};
+
+// every weight random: accumulators that go negative and past 127, so the
+// clipping gets exercised along with the sums
+static NetworkWriter randomNetwork()
+{
+    std::mt19937 random(0x4E4E);
+    auto between = [&random](int low, int high) { return std::uniform_int_distribution<int>(low, high)(random); };
+    NetworkWriter network(16);
+    for (int i = 0; i < NnueAccumulatorSize; i++) {
+        network.featureBias()[i] = (int16_t)between(-20, 60);
+    }
+    for (int feature = 0; feature < NnueInputs; feature++) {
+        int16_t* row = network.featureWeights(feature);
+        for (int i = 0; i < NnueAccumulatorSize; i++) {
+            row[i] = (int16_t)between(-16, 16);
+        }
+    }
+    for (int out = 0; out < NnueHiddenSize; out++) {
+        network.hidden1Bias()[out] = between(-2000, 4000);
+        network.hidden2Bias()[out] = between(-500, 1000);
+        for (int i = 0; i < 2 * NnueAccumulatorSize; i++) {
+            network.hidden1Weights(out)[i] = (int8_t)between(-128, 127);
+        }
+        for (int i = 0; i < NnueHiddenSize; i++) {
+            network.hidden2Weights(out)[i] = (int8_t)between(-128, 127);
+        }
+        network.outputWeights()[out] = (int8_t)between(-128, 127);
+    }
+    *network.outputBias() = between(-1000, 1000);
+    return network;
+}
+
+// counts pieces: accumulator lane k is 10 * the number of pieces of kind k (own
+// pawns, enemy pawns, own knights, ...), both hidden layers pass the first ten
+// lanes through, and the output weighs each by a tenth of its centipawn value.
+// so it scores exactly the side to move's material balance
+static NetworkWriter materialNetwork()
+{
+    NetworkWriter network(1);
+    for (int king = 0; king < 64; king++) {
+        for (int kind = 0; kind < NnuePieceKinds; kind++) {
+            for (int square = 0; square < 64; square++) {
+                network.featureWeights((king * NnuePieceKinds + kind) * 64 + square)[kind] = 10;
+            }
+        }
+    }
+    for (int kind = 0; kind < NnuePieceKinds; kind++) {
+        network.hidden1Weights(kind)[kind] = 1 << NnueWeightShift;
+        network.hidden2Weights(kind)[kind] = 1 << NnueWeightShift;
+        int value = PieceValues[Pawn + kind / 2] / 10;
+        network.outputWeights()[kind] = (int8_t)(kind % 2 == 0 ? value : -value);
+    }
+    return network;
+}
+
+static int materialBalance(const Position& position)
+{
+    int balance = 0;
+    for (int type = Pawn; type <= Queen; type++) {
+        balance += PieceValues[type] * (countOnes(position.pieces(pieceIndexFor((ChessPiece)type, WHITE)))
+                                        - countOnes(position.pieces(pieceIndexFor((ChessPiece)type, BLACK))));
+    }
+    return balance * position.sideToMove();
+}
+
+static std::vector<NnueBackend> availableBackends()
+{
+    NnueBackend best = bestNnueBackend();
+    std::vector<NnueBackend> backends = { NNUE_SCALAR };
+    if (best >= NNUE_SSE41) {
+        backends.push_back(NNUE_SSE41);
+    }
+    if (best >= NNUE_AVX2) {
+        backends.push_back(NNUE_AVX2);
+    }
+    return backends;
+}
+
+// random walk below position: at each node maybe evaluate (so several plies can
+// pass between evaluations), then try a few random moves or a null move
+struct WalkCheck
+{
+    std::mt19937 random{0xACC};
+    std::vector<NnueStack> stacks; // one per backend
+    std::vector<NnueBackend> backends;
+    int evaluations = 0;
+    int failures = 0;
+
+    void check(Position& position)
+    {
+        NnueAccumulator expected;
+        NnueKernels = NNUE_SCALAR;
+        NnueStack::refresh(position, expected);
+        int score = Network.evaluate(expected, position.sideToMove());
+        for (size_t i = 0; i < backends.size(); i++) {
+            NnueKernels = backends[i];
+            const NnueAccumulator& accumulator = stacks[i].accumulatorFor(position);
+            if (std::memcmp(accumulator.values, expected.values, sizeof(expected.values)) != 0
+                || stacks[i].evaluate(position) != score) {
+                failures++;
+            }
+        }
+        evaluations++;
+    }
+
+    void walk(Position& position, int depth)
+    {
+        if (random() % 3 == 0 || depth == 0) {
+            check(position);
+        }
+        if (depth == 0) {
+            return;
+        }
+        MoveList moves;
+        generateAllMoves(position, moves);
+        for (int i = 0; i < 3 && !moves.empty(); i++) {
+            position.makeMove(moves[random() % moves.size()]);
+            walk(position, depth - 1);
+            position.unmakeMove();
+        }
+        if (!position.inCheck() && random() % 4 == 0) {
+            position.makeNullMove();
+            walk(position, depth - 1);
+            position.unmakeNullMove();
+        }
+    }
+};
+
+// every position in a fixed tree below each test position, each one evaluated as
+// the search's quiescence stand pat would: so most are one move from their parent
+template <typename Evaluator>
+static double timeEvaluations(Evaluator evaluator, int depth, int iterations, int& evaluations, int64_t& checksum)
+{
+    evaluations = 0;
+    auto start = std::chrono::steady_clock::now();
+    std::function<void(Position&, int)> walk = [&](Position& position, int remaining) {
+        checksum += evaluator(position);
+        evaluations++;
+        if (remaining == 0) {
+            return;
+        }
+        MoveList moves;
+        generateAllMoves(position, moves);
+        for (int i = 0; i < moves.size(); i++) {
+            position.makeMove(moves[i]);
+            walk(position, remaining - 1);
+            position.unmakeMove();
+        }
+    };
+    Position position;
+    for (int i = 0; i < iterations; i++) {
+        for (const std::string& fen : Positions) {
+            position.setFromFEN(fen);
+            walk(position, depth);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return evaluations / seconds;
+}
+
+int main(int argc, char** argv)
+{
+    initMagicBitboards();
+    if (argc > 2 && std::string(argv[1]) == "--write") {
+        if (!materialNetwork().save(argv[2])) {
+            std::cerr << "can't write " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+    int iterations = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 3;
+    NnueBackend best = bestNnueBackend();
+    std::vector<NnueBackend> backends = availableBackends();
+    std::cout << "nnue best backend " << nnueBackendName(best) << "\n";
+
+    std::string path = "nnue_check.nnue";
+    int failures = 0;
+
+    // incremental updates and backends against a full refresh on the scalar kernels
+    if (!randomNetwork().save(path) || !loadNetwork(path)) {
+        std::cerr << "can't write or load " << path << "\n";
+        return 1;
+    }
+    WalkCheck walk;
+    walk.backends = backends;
+    walk.stacks.resize(backends.size());
+    Position position;
+    for (const std::string& fen : Positions) {
+        position.setFromFEN(fen);
+        walk.walk(position, 5);
+    }
+    std::cout << "random net: " << walk.evaluations << " positions, " << walk.failures << " failed\n";
+    failures += walk.failures;
+
+    // the material network end to end, against counting the pieces
+    Network.unload();
+    if (!materialNetwork().save(path) || !loadNetwork(path)) {
+        std::cerr << "can't write or load " << path << "\n";
+        return 1;
+    }
+    int materialFailures = 0;
+    int materialChecks = 0;
+    for (NnueBackend backend : backends) {
+        NnueKernels = backend;
+        NnueStack stack;
+        std::mt19937 random(0x3A7);
+        for (const std::string& fen : Positions) {
+            position.setFromFEN(fen);
+            for (int ply = 0; ply < 40; ply++) {
+                MoveList moves;
+                generateAllMoves(position, moves);
+                if (moves.empty()) {
+                    break;
+                }
+                position.makeMove(moves[random() % moves.size()]);
+                // a side without a king sees no pieces, there's no count to compare
+                if (position.kingSquare(position.sideToMove()) == NO_SQUARE) {
+                    continue;
+                }
+                materialChecks++;
+                if (stack.evaluate(position) != materialBalance(position)) {
+                    materialFailures++;
+                }
+            }
+        }
+    }
+    std::cout << "material net: " << materialChecks << " positions, " << materialFailures << " failed\n";
+    failures += materialFailures;
+
+    // speed
+    int64_t checksum = 0;
+    int evaluations = 0;
+    PawnTable pawnTable;
+    double classical = timeEvaluations([&pawnTable](const Position& p) { return evaluateBoard(p, &pawnTable); }, 3, iterations, evaluations, checksum);
+    std::cout << std::fixed << std::setprecision(0) << evaluations << " evaluations per run\n"
+              << std::setw(12) << "classical" << std::setw(12) << classical / 1000 << " k/s\n";
+    for (NnueBackend backend : backends) {
+        NnueKernels = backend;
+        NnueStack stack;
+        double rate = timeEvaluations([&stack](const Position& p) { return stack.evaluate(p); }, 3, iterations, evaluations, checksum);
+        std::cout << std::setw(12) << nnueBackendName(backend) << std::setw(12) << rate / 1000 << " k/s\n";
+    }
+    NnueKernels = best;
+    double refreshRate = timeEvaluations([](const Position& p) {
+        NnueAccumulator accumulator;
+        NnueStack::refresh(p, accumulator);
+        return Network.evaluate(accumulator, p.sideToMove());
+    }, 3, iterations, evaluations, checksum);
+    std::cout << std::setw(12) << "refresh" << std::setw(12) << refreshRate / 1000 << " k/s (" << nnueBackendName(best) << ", no incremental updates)\n";
+    // keeps the work from being optimized away
+    std::cout << "checksum " << checksum << "\n";
+
+    Network.unload();
+    std::remove(path.c_str());
+    return failures ? 1 : 0;
+}
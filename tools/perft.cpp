@@ -0,0 +1,231 @@
+//
+// move generator verification and benchmark, no GUI
+//
+//   perft [--magic] <fen> <depth> [threads] [hashMB]
+//   perft [--magic] --suite [threads] [hashMB]
+//
+// the first form prints the node count below every root move (divide), the
+// total and nodes per second. --suite runs a set of standard positions with
+// known counts and exits non-zero on any mismatch, it's what ctest runs.
+// leaves are bulk counted (the last ply only counts the generated moves),
+// root moves are shared out between threads and hashMB > 0 adds a table of
+// subtree counts so transpositions are only counted once. sliders use PEXT
+// indexing where the CPU has a fast one, --magic forces the magic multiply.
+//
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../classes/MagicBitboards.h"
+#include "../classes/MoveGenerator.h"
+
+struct SuitePosition
+{
+    const char* fen;
+    int depth;
+    uint64_t nodes;
+};
+
+// the usual perft positions, depths kept low enough for a quick ctest run
+static const SuitePosition Suite[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603 },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624 },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333 },
+    { "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 4, 422333 },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+};
+
+//
+// subtree counts by position and depth. threads share it without locking: a
+// slot keeps key ^ nodes next to nodes, so a slot torn by two writers fails
+// the key check instead of handing back a wrong count
+//
+class PerftTable
+{
+public:
+    explicit PerftTable(size_t megabytes)
+    {
+        size_t count = 1;
+        while (count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) {
+            count *= 2;
+        }
+        _mask = count - 1;
+        _slots = std::make_unique<Slot[]>(count);
+    }
+
+    bool probe(uint64_t key, int depth, uint64_t& nodes) const
+    {
+        uint64_t check = key ^ DepthKeys(depth);
+        const Slot& slot = _slots[check & _mask];
+        uint64_t stored = slot.nodes.load(std::memory_order_relaxed);
+        if (stored == 0 || (slot.keyXorNodes.load(std::memory_order_relaxed) ^ stored) != check) {
+            return false;
+        }
+        nodes = stored;
+        return true;
+    }
+
+    void store(uint64_t key, int depth, uint64_t nodes)
+    {
+        uint64_t check = key ^ DepthKeys(depth);
+        Slot& slot = _slots[check & _mask];
+        slot.keyXorNodes.store(check ^ nodes, std::memory_order_relaxed);
+        slot.nodes.store(nodes, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<uint64_t> keyXorNodes{0};
+        std::atomic<uint64_t> nodes{0};
+    };
+
+    // the same position at another depth is a different entry
+    static uint64_t DepthKeys(int depth) { return (uint64_t)depth * 0x9E3779B97F4A7C15ULL; }
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+};
+
+static uint64_t perft(Position& position, int depth, PerftTable* table)
+{
+    MoveList moves;
+    generateAllMoves(position, moves);
+    // every generated move is legal, so the last ply is just the count
+    if (depth <= 1) {
+        return depth == 1 ? moves.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+    if (table && table->probe(position.key(), depth, nodes)) {
+        return nodes;
+    }
+    for (const BitMove& move : moves) {
+        position.makeMove(move);
+        nodes += perft(position, depth - 1, table);
+        position.unmakeMove();
+    }
+    if (table) {
+        table->store(position.key(), depth, nodes);
+    }
+    return nodes;
+}
+
+// counts below every root move, the root moves handed out to threads one at a time
+static std::vector<uint64_t> divide(const Position& root, const MoveList& rootMoves, int depth, int threads, PerftTable* table)
+{
+    std::vector<uint64_t> counts(rootMoves.size(), 0);
+    std::atomic<int> nextMove{0};
+    auto work = [&]() {
+        Position position = root;
+        int index;
+        while ((index = nextMove.fetch_add(1)) < rootMoves.size()) {
+            position.makeMove(rootMoves[index]);
+            counts[index] = perft(position, depth - 1, table);
+            position.unmakeMove();
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (int i = 1; i < threads; i++) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    return counts;
+}
+
+static uint64_t run(const std::string& fen, int depth, int threads, size_t hashMB, bool printDivide, int64_t& elapsedMs)
+{
+    Position position;
+    position.setFromFEN(fen);
+    std::unique_ptr<PerftTable> table = hashMB > 0 ? std::make_unique<PerftTable>(hashMB) : nullptr;
+
+    auto start = std::chrono::steady_clock::now();
+    MoveList rootMoves;
+    generateAllMoves(position, rootMoves);
+    uint64_t total = depth <= 1 ? (depth == 1 ? rootMoves.size() : 1) : 0;
+    std::vector<uint64_t> counts;
+    if (depth > 1) {
+        counts = divide(position, rootMoves, depth, threads, table.get());
+        for (uint64_t count : counts) {
+            total += count;
+        }
+    }
+    elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    if (printDivide) {
+        for (int i = 0; i < (int)counts.size(); i++) {
+            std::cout << moveToString(rootMoves[i]) << ": " << counts[i] << "\n";
+        }
+    }
+    return total;
+}
+
+static int runSuite(int threads, size_t hashMB)
+{
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    int64_t totalMs = 0;
+    for (const SuitePosition& test : Suite) {
+        int64_t ms = 0;
+        uint64_t nodes = run(test.fen, test.depth, threads, hashMB, false, ms);
+        totalNodes += nodes;
+        totalMs += ms;
+        bool ok = nodes == test.nodes;
+        failures += ok ? 0 : 1;
+        std::cout << (ok ? "ok   " : "FAIL ") << "depth " << test.depth << std::setw(12) << nodes;
+        if (!ok) {
+            std::cout << " (expected " << test.nodes << ")";
+        }
+        std::cout << "  " << test.fen << "\n";
+    }
+    std::cout << totalNodes << " nodes " << totalMs << " ms "
+              << totalNodes * 1000 / std::max<int64_t>(totalMs, 1) << " nps, "
+              << failures << " failed\n";
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    SliderBackend backend = bestSliderBackend();
+    if (argc > 1 && std::string(argv[1]) == "--magic") {
+        backend = SLIDERS_MAGIC;
+        argc--;
+        argv++;
+    }
+    if (argc < 2) {
+        std::cerr << "usage: perft [--magic] <fen> <depth> [threads] [hashMB]\n"
+                  << "       perft [--magic] --suite [threads] [hashMB]\n";
+        return 2;
+    }
+
+    initMagicBitboards(backend);
+    std::cout << "sliders " << sliderBackendName(backend) << "\n";
+
+    int result = 0;
+    if (std::string(argv[1]) == "--suite") {
+        int threads = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 1;
+        size_t hashMB = argc > 3 ? std::atoi(argv[3]) : 0;
+        result = runSuite(threads, hashMB);
+    } else {
+        int depth = argc > 2 ? std::atoi(argv[2]) : 1;
+        int threads = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 1;
+        size_t hashMB = argc > 4 ? std::atoi(argv[4]) : 0;
+        int64_t ms = 0;
+        uint64_t nodes = run(argv[1], depth, threads, hashMB, true, ms);
+        std::cout << "\nnodes " << nodes << "\ntime " << ms << " ms\nnps "
+                  << nodes * 1000 / std::max<int64_t>(ms, 1) << "\n";
+    }
+
+    return result;
+}
@@ -0,0 +1,93 @@
+//
+// forward pruning benchmark, no GUI
+//
+//   pruning [depth]
+//
+// searches the bench positions to a fixed depth on one thread with every
+// combination of null-move pruning, late move reductions and late move pruning
+// and reports nodes, time, the effective branching factor (how much each extra
+// ply multiplied the cost of an iteration over the last two iterations) and how
+// many best moves agree with the search that prunes nothing.
+//
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../classes/MagicBitboards.h"
+#include "../classes/Position.h"
+#include "../classes/Search.h"
+#include "BenchPositions.h"
+
+int main(int argc, char** argv)
+{
+    int depth = std::max(argc > 1 ? std::atoi(argv[1]) : 7, 3);
+
+    initMagicBitboards();
+    Search search;
+    search.resizeHash(64);
+    search.setThreads(1);
+
+    // nodes searched by the main thread when each iteration finished
+    std::vector<uint64_t> iterationNodes;
+    search.setInfoHandler([&iterationNodes](const SearchInfo& info) {
+        iterationNodes.push_back(info.nodes);
+    });
+
+    std::cout << "depth " << depth << ", " << BenchPositions.size() << " positions\n";
+    std::cout << std::setw(6) << "nmp" << std::setw(6) << "lmr" << std::setw(6) << "lmp"
+              << std::setw(14) << "nodes" << std::setw(12) << "time ms" << std::setw(8) << "ebf"
+              << std::setw(8) << "agree" << "\n";
+
+    std::vector<BitMove> unprunedMoves;
+    for (int combination = 0; combination < 8; combination++) {
+        PruningOptions pruning;
+        pruning.nullMove = combination & 1;
+        pruning.lateMoveReductions = combination & 2;
+        pruning.lateMovePruning = combination & 4;
+        search.setPruning(pruning);
+
+        uint64_t totalNodes = 0;
+        int64_t totalMs = 0;
+        double lastIterations = 0;
+        double earlierIterations = 0;
+        int agree = 0;
+        for (size_t i = 0; i < BenchPositions.size(); i++) {
+            Position position;
+            position.setFromFEN(BenchPositions[i]);
+            search.newGame();
+            iterationNodes.clear();
+
+            SearchLimits limits;
+            limits.maxDepth = depth;
+            SearchResult result = search.think(position, limits);
+            totalNodes += result.nodes;
+            totalMs += result.timeMs;
+
+            // cost of the last iteration against the one two plies earlier
+            size_t count = iterationNodes.size();
+            if (count >= 4) {
+                lastIterations += (double)(iterationNodes[count - 1] - iterationNodes[count - 2]);
+                earlierIterations += (double)(iterationNodes[count - 3] - iterationNodes[count - 4]);
+            }
+
+            if (combination == 0) {
+                unprunedMoves.push_back(result.bestMove);
+            }
+            if (result.bestMove == unprunedMoves[i]) {
+                agree++;
+            }
+        }
+
+        double ebf = earlierIterations > 0 ? std::sqrt(lastIterations / earlierIterations) : 0.0;
+        std::cout << std::setw(6) << (pruning.nullMove ? "on" : "-")
+                  << std::setw(6) << (pruning.lateMoveReductions ? "on" : "-")
+                  << std::setw(6) << (pruning.lateMovePruning ? "on" : "-")
+                  << std::setw(14) << totalNodes << std::setw(12) << totalMs
+                  << std::setw(8) << std::fixed << std::setprecision(2) << ebf
+                  << std::setw(6) << agree << "/" << BenchPositions.size() << "\n";
+    }
+
+    return 0;
+}